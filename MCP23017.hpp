@@ -24,6 +24,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <linux/i2c.h>
 #include <linux/i2c-dev.h>
 #include <stdexcept>
 #include <string>
@@ -38,18 +39,145 @@ struct IntEvent {
     bool level;
 };
 
+struct PatternAlarm {
+    uint16_t flags;     // INTF: pin(s) that raised the alarm
+    uint16_t captured;  // INTCAP: all pins at the moment of the alarm
+    uint16_t violated;  // Watched pins that differ from the pattern right now
+};
+
+
+/**
+ * Collects register reads and writes for one or more devices on a bus and sends
+ * them as one I2C_RDWR message list, with repeated STARTs and no STOP in between.
+ * Lists longer than the kernel limit are split, keeping a register/read pair together.
+ */
+class I2CBurst {
+public:
+
+    void write(uint16_t addr, uint8_t reg, const uint8_t *data, uint16_t len) {
+        parts.push_back({ addr, 0, uint32_t(buf.size()), uint16_t(len + 1), nullptr });
+        buf.push_back(reg);
+        buf.insert(buf.end(), data, data + len);
+    }
+
+
+    void write(uint16_t addr, uint8_t reg, uint8_t value) {
+        write(addr, reg, &value, 1);
+    }
+
+
+    void read(uint16_t addr, uint8_t reg, uint8_t *dest, uint16_t len) {
+        parts.push_back({ addr, 0, uint32_t(buf.size()), 1, nullptr });
+        buf.push_back(reg);
+        parts.push_back({ addr, I2C_M_RD, 0, len, dest });
+    }
+
+
+    size_t size() const { return parts.size(); }
+
+    // Bytes on the wire: data plus one address byte per message, without START/STOP and ACK bits.
+    size_t wireBytes() const {
+        size_t bytes = 0;
+        for (auto &p : parts) bytes += p.len + 1;
+        return bytes;
+    }
+
+    bool empty() const { return parts.empty(); }
+
+    void clear() {
+        buf.clear();
+        parts.clear();
+    }
+
+
+    void reserve(size_t messages, size_t bytes) {
+        parts.reserve(messages);
+        msgs.reserve(messages < I2C_RDWR_IOCTL_MAX_MSGS ? messages : I2C_RDWR_IOCTL_MAX_MSGS);
+        buf.reserve(bytes);
+    }
+
+
+    bool run(int fd) {
+        bool ok = true;
+        msgs.clear();
+
+        for (size_t i = 0; i < parts.size(); i++) {
+            bool pair = (i + 1 < parts.size()) && (parts[i + 1].flags & I2C_M_RD);
+            if (msgs.size() + (pair ? 2 : 1) > I2C_RDWR_IOCTL_MAX_MSGS) ok &= flush(fd);
+
+            const Part &p = parts[i];
+            msgs.push_back({ p.addr, p.flags, p.len, p.dest ? p.dest : &buf[p.offset] });
+        }
+        if (!msgs.empty()) ok &= flush(fd);
+
+        return ok;
+    }
+
+
+    /* Runs at most max messages from message from on, as one transaction. A register address
+     * always stays together with its read. Returns the next message to run, size() when done.
+     */
+    size_t runSlice(int fd, size_t from, size_t max, bool &ok) {
+        if (max > I2C_RDWR_IOCTL_MAX_MSGS) max = I2C_RDWR_IOCTL_MAX_MSGS;
+        msgs.clear();
+
+        size_t i = from;
+        for (; i < parts.size(); i++) {
+            bool pair = (i + 1 < parts.size()) && (parts[i + 1].flags & I2C_M_RD);
+            if (!msgs.empty() && !(parts[i].flags & I2C_M_RD) && msgs.size() + (pair ? 2 : 1) > max) break;
+
+            const Part &p = parts[i];
+            msgs.push_back({ p.addr, p.flags, p.len, p.dest ? p.dest : &buf[p.offset] });
+        }
+        ok = msgs.empty() || flush(fd);
+        return i;
+    }
+
+
+private:
+    struct Part {
+        uint16_t addr;
+        uint16_t flags;
+        uint32_t offset;
+        uint16_t len;
+        uint8_t *dest;
+    };
+
+    std::vector<uint8_t> buf;
+    std::vector<Part> parts;
+    std::vector<i2c_msg> msgs;
+
+    bool flush(int fd) {
+        i2c_rdwr_ioctl_data data = { msgs.data(), uint32_t(msgs.size()) };
+        msgs.clear();
+        try {
+           if (ioctl(fd, I2C_RDWR, &data) < 0) throw std::runtime_error("I2C burst failed");
+        }
+        catch (const std::runtime_error& e) {
+           std::cerr << "Error: " << e.what() << std::endl;
+           return false;
+        }
+        return true;
+    }
+};
+
 class MCP23017 {
 public:
    
-    MCP23017(uint8_t address = 0x20, const std::string &i2cDev = "/dev/i2c-1") {
+    // reset = false attaches to a running chip and keeps its registers (warm attach).
+    MCP23017(uint8_t address = 0x20, const std::string &i2cDev = "/dev/i2c-1", bool reset = true) : addr(address), dev(i2cDev) {
         fd = open(i2cDev.c_str(), O_RDWR);
 
         try {
            if (fd < 0) throw std::runtime_error("I2C write failed");
            if (ioctl(fd, I2C_SLAVE, address) < 0) throw std::runtime_error("I2C ioctl failed");
 
-           writeReg(IODIRA, 0xFF);
-           writeReg(IODIRB, 0xFF);          
+           if (reset) {
+              writeReg(IODIRA, 0xFF);
+              writeReg(IODIRB, 0xFF);
+           }
+           // Another process or an earlier run may have switched sequential operation off (IOCON SEQOP = 1).
+           sequential = !(readReg(IOCON) & (1 << 5));
         }
         catch (const std::runtime_error& e) {
            std::cerr << "Error: " << e.what() << std::endl;
@@ -118,6 +246,31 @@ public:
         }
         writeReg(reg, val);
     }
+
+
+    void pinPulse(uint8_t pin, pin_Value level = HIGH, uint8_t width = 1) {
+        if (!pinCheck(pin)) return;
+        if (level != HIGH && level != LOW) {
+            std::cerr << "Invalid input: pinPulse(pin, HIGH/LOW, width)" << std::endl;
+            return;
+        }
+
+        uint16_t mask = uint16_t(1) << pin;
+        if (pin < 8) pulse(OLATA, uint8_t(mask), level, width);
+        else pulse(OLATB, uint8_t(mask >> 8), level, width);
+    }
+
+
+    void portPulse(uint16_t mask, pin_Value level = HIGH, uint8_t width = 1) {
+        if (level != HIGH && level != LOW) {
+            std::cerr << "Invalid input: portPulse(mask, HIGH/LOW, width)" << std::endl;
+            return;
+        }
+
+        if (!(mask & 0xFF00)) pulse(OLATA, uint8_t(mask), level, width);
+        else if (!(mask & 0x00FF)) pulse(OLATB, uint8_t(mask >> 8), level, width);
+        else pulse16(mask, level, width);
+    }
     
 
     pin_Value pinRead(uint8_t pin) {
@@ -192,9 +345,102 @@ public:
         }
         writeReg(regINTCON, intConVal);
         writeReg(regDEFVAL, defVal);
+
+        edgeMask &= ~(uint16_t(1) << pin);
+        if (pin < 8) defvalShadow = (defvalShadow & 0xFF00) | defVal;
+        else defvalShadow = (defvalShadow & 0x00FF) | (uint16_t(defVal) << 8);
+    }
+
+
+    void intEdgeMode(uint8_t pin, int_Mode mode) {
+        if (!pinCheck(pin)) return;
+        if (mode != RISING && mode != FALLING) {
+            std::cerr << "Invalid input: intEdgeMode(pin, RISING/FALLING)" << std::endl;
+            return;
+        }
+
+        uint8_t regINTCON = (pin < 8) ? INTCONA : INTCONB;
+        uint16_t bit = uint16_t(1) << pin;
+
+        uint8_t regs[2] = {0, 0};
+        uint8_t gpio[2] = {0, 0};
+        I2CBurst burst;
+        burstRead(burst, DEFVALA, regs, 2);
+        burstRead(burst, GPIOA, gpio, 2);
+        if (!burst.run(fd)) return;
+
+        // Arm on the present level, the next transition in either direction re-arms DEFVAL.
+        uint16_t level = (uint16_t(gpio[1]) << 8) | gpio[0];
+        defvalShadow = (((uint16_t(regs[1]) << 8) | regs[0]) & ~bit) | (level & bit);
+
+        edgeMask |= bit;
+        if (mode == RISING) edgeRising |= bit;
+        else edgeRising &= ~bit;
+
+        writeReg(regINTCON, readReg(regINTCON) | (1 << (pin % 8)));
+        writeReg((pin < 8) ? DEFVALA : DEFVALB, (pin < 8) ? uint8_t(defvalShadow) : uint8_t(defvalShadow >> 8));
     }
     
     
+    void setPatternAlarm(uint16_t pattern, uint16_t mask) {
+        // GPINTENA/B, DEFVALA/B, INTCONA/B are six consecutive registers.
+        uint8_t regs[6] = {0, 0, 0, 0, 0, 0};
+        I2CBurst burst;
+        burstRead(burst, GPINTENA, regs, 6);
+        if (!burst.run(fd)) return;
+
+        uint16_t gpinten = (uint16_t(regs[1]) << 8) | regs[0];
+        uint16_t defval  = (uint16_t(regs[3]) << 8) | regs[2];
+        uint16_t intcon  = (uint16_t(regs[5]) << 8) | regs[4];
+
+        gpinten |= mask;
+        defval   = (defval & ~mask) | (pattern & mask);
+        intcon  |= mask;
+
+        uint8_t out[6] = { uint8_t(gpinten), uint8_t(gpinten >> 8), uint8_t(defval), uint8_t(defval >> 8),
+                           uint8_t(intcon), uint8_t(intcon >> 8) };
+        burst.clear();
+        burstWrite(burst, GPINTENA, out, 6);
+        if (!burst.run(fd)) return;
+
+        edgeMask &= ~mask;
+        defvalShadow = defval;
+        patternValue = (patternValue & ~mask) | (pattern & mask);
+        patternMask |= mask;
+    }
+
+
+    void clearPatternAlarm(uint16_t mask = 0xFFFF) {
+        uint8_t regs[2] = {0, 0};
+        I2CBurst burst;
+        burstRead(burst, GPINTENA, regs, 2);
+        if (!burst.run(fd)) return;
+
+        uint16_t gpinten = ((uint16_t(regs[1]) << 8) | regs[0]) & ~(mask & patternMask);
+        regs[0] = uint8_t(gpinten);
+        regs[1] = uint8_t(gpinten >> 8);
+
+        burst.clear();
+        burstWrite(burst, GPINTENA, regs, 2);
+        burst.run(fd);
+        patternMask &= ~mask;
+    }
+
+
+    // INTF, INTCAP and GPIO in one read. Reading releases INT, it asserts again while the pattern is still violated.
+    PatternAlarm getPatternAlarm() {
+        uint8_t regs[6] = {0, 0, 0, 0, 0, 0};
+        I2CBurst burst;
+        burstRead(burst, INTFA, regs, 6);
+        if (!burst.run(fd)) return { 0, 0, 0 };
+
+        uint16_t gpio = (uint16_t(regs[5]) << 8) | regs[4];
+        return { uint16_t((uint16_t(regs[1]) << 8) | regs[0]),
+                 uint16_t((uint16_t(regs[3]) << 8) | regs[2]),
+                 uint16_t((gpio ^ patternValue) & patternMask) };
+    }
+
+
     uint16_t getInterruptFlags(bool clear = false) {
         return readIntFlags(clear);
     }
@@ -222,6 +468,9 @@ public:
     }
 
 
+    /* Flagged pins with their captured levels. Only with clear the interrupt is released,
+     * edge mode pins are re-armed then; without it the chip state is left untouched.
+     */
     std::vector<IntEvent> getIntCapture(bool clear = false) {
         uint8_t a = readReg(INTFA);
         uint8_t b = readReg(INTFB);
@@ -231,6 +480,13 @@ public:
         uint8_t capB = readReg(INTCAPB);
         uint16_t captured = (uint16_t(capB) << 8) | capA;
 
+        if (clear && (flags & edgeMask)) {
+            I2CBurst burst;
+            flags = queueEdgeRearm(burst, flags, captured);
+            burst.run(fd);
+        }
+        else flags &= ~(flags & edgeMask & (captured ^ edgeRising));  // Return transitions, as queueEdgeRearm()
+
         std::vector<IntEvent> events;
         for (uint16_t pin = 0; pin < 16; pin++) {
             if (flags & (1 << pin)) {
@@ -273,6 +529,7 @@ public:
 
      void setSequentialOperation(bool enabled) {
          uint8_t iocon = readReg(IOCON);
+         sequential = enabled;
 
          if (enabled) {
              iocon &= ~(1 << 5);
@@ -284,9 +541,54 @@ public:
       }
 
 
+    uint8_t address() const { return addr; }
+
+    const std::string &device() const { return dev; }
+
+    int handle() const { return fd; }
+
+
+    // Queue a read of len consecutive registers, split per register when SEQOP is off.
+    void burstRead(I2CBurst &burst, uint8_t reg, uint8_t *dest, uint8_t len) const {
+        if (sequential) burst.read(addr, reg, dest, len);
+        else for (uint8_t i = 0; i < len; i++) burst.read(addr, reg + i, dest + i, 1);
+    }
+
+
+    void burstWrite(I2CBurst &burst, uint8_t reg, const uint8_t *data, uint8_t len) const {
+        if (sequential) burst.write(addr, reg, data, len);
+        else for (uint8_t i = 0; i < len; i++) burst.write(addr, reg + i, data[i]);
+    }
+
+
+    /* Edge mode service step: queues DEFVAL = captured level for flagged edge pins, followed by the
+     * GPIO read that clears the interrupt, so both go out in the caller's next transaction.
+     * Returns the flags without the re-arm transitions that run against the requested direction.
+     */
+    uint16_t queueEdgeRearm(I2CBurst &burst, uint16_t flags, uint16_t captured) {
+        uint16_t edge = flags & edgeMask;
+        if (!edge) return flags;
+
+        defvalShadow = (defvalShadow & ~edge) | (captured & edge);
+        rearm[0] = uint8_t(defvalShadow);
+        rearm[1] = uint8_t(defvalShadow >> 8);
+
+        if ((edge & 0x00FF) && (edge & 0xFF00)) {
+            burstWrite(burst, DEFVALA, rearm, 2);
+            burstRead(burst, GPIOA, scratch, 2);
+        } else if (edge & 0x00FF) {
+            burstWrite(burst, DEFVALA, &rearm[0], 1);
+            burstRead(burst, GPIOA, &scratch[0], 1);
+        } else {
+            burstWrite(burst, DEFVALB, &rearm[1], 1);
+            burstRead(burst, GPIOB, &scratch[1], 1);
+        }
+
+        uint16_t against = edge & (captured ^ edgeRising);
+        return flags & ~against;
+    }
+
 
-private:
-    int fd;
     static constexpr uint8_t IODIRA  = 0x00;
     static constexpr uint8_t IODIRB  = 0x01;
     static constexpr uint8_t GPPUA   = 0x0C;
@@ -309,6 +611,21 @@ private:
     static constexpr uint8_t INTCONA = 0x08;
     static constexpr uint8_t INTCONB = 0x09;
 
+
+private:
+    int fd;
+    uint8_t addr;
+    std::string dev;
+    bool sequential = true;
+
+    uint16_t edgeMask = 0;
+    uint16_t edgeRising = 0;
+    uint16_t defvalShadow = 0;
+    uint16_t patternValue = 0;
+    uint16_t patternMask = 0;
+    uint8_t rearm[2] = {0, 0};
+    uint8_t scratch[2] = {0, 0};
+
     uint16_t readIntFlags(bool clear) {
         uint8_t a = readReg(INTFA);
         uint8_t b = readReg(INTFB);
@@ -321,6 +638,45 @@ private:
         return flags;
     }
 
+    // Active writes followed by one idle write, all inside a single ioctl.
+    void pulse(uint8_t reg, uint8_t mask, pin_Value level, uint8_t width) {
+        uint8_t val = readReg(reg);
+        uint8_t active = (level == HIGH) ? (val | mask) : (val & ~mask);
+        uint8_t idle   = (level == HIGH) ? (val & ~mask) : (val | mask);
+
+        I2CBurst burst;
+        for (uint8_t i = 0; i < width; i++) burst.write(addr, reg, active);
+        burst.write(addr, reg, idle);
+        runPulse(burst, width);
+    }
+
+    void pulse16(uint16_t mask, pin_Value level, uint8_t width) {
+        uint8_t cur[2] = {0, 0};
+        I2CBurst burst;
+        burstRead(burst, OLATA, cur, 2);
+        if (!burst.run(fd)) return;
+
+        uint16_t val    = (uint16_t(cur[1]) << 8) | cur[0];
+        uint16_t active = (level == HIGH) ? (val | mask) : (val & ~mask);
+        uint16_t idle   = (level == HIGH) ? (val & ~mask) : (val | mask);
+        uint8_t  act[2] = { uint8_t(active), uint8_t(active >> 8) };
+        uint8_t  rst[2] = { uint8_t(idle), uint8_t(idle >> 8) };
+
+        burst.clear();
+        for (uint8_t i = 0; i < width; i++) burstWrite(burst, OLATA, act, 2);
+        burstWrite(burst, OLATA, rst, 2);
+        runPulse(burst, width);
+    }
+
+    void runPulse(I2CBurst &burst, uint8_t width) {
+        size_t perStep = burst.size() / (width + 1);
+        if (width < 1 || burst.size() > I2C_RDWR_IOCTL_MAX_MSGS) {
+            std::cerr << "Valid pulse width 1-" << (I2C_RDWR_IOCTL_MAX_MSGS / perStep - 1) << std::endl;
+            return;
+        }
+        burst.run(fd);
+    }
+
     bool pinCheck(int pin) {
        if (pin < 0 || pin > 15) {
           std::cerr << "Valid Pinnums 0-15" << std::endl;
@@ -0,0 +1,145 @@
+/**
+ * @file MCP23017Broker.hpp
+ * @brief Protocol and client for the mcp23017-broker daemon.
+ *
+ * The broker owns the I2C buses and serves several processes over a Unix domain socket.
+ * Each message is one fixed size BrokerFrame in a SOCK_SEQPACKET packet.
+ * Writes of all clients are coalesced per device, input changes are read once and fanned out to all subscribers.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+enum broker_Op : uint8_t {
+    BROKER_SUBSCRIBE   = 1,  // mask = pins to watch, 0 unsubscribes
+    BROKER_WRITE       = 2,  // OLAT bits under mask
+    BROKER_CONFIG      = 3,  // IODIR bits under mask, value = GPPU bits under mask
+    BROKER_SNAPSHOT    = 4,  // Reply: bits = GPIO, mask = OLAT, value = IODIR
+    BROKER_EVENT       = 5,  // bits = GPIO, mask = changed subscribed pins
+    BROKER_ERROR       = 6,  // value = op that failed
+    BROKER_INFO        = 7   // Reply: dev = number of devices
+};
+
+struct BrokerFrame {
+    uint8_t op;
+    uint8_t dev;
+    uint16_t bits;
+    uint16_t mask;
+    uint16_t value;
+};
+
+static const char *const BROKER_SOCKET = "/run/mcp23017.sock";
+
+
+class BrokerClient {
+public:
+
+    explicit BrokerClient(const std::string &path = BROKER_SOCKET) {
+        fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+
+        try {
+           if (fd < 0) throw std::runtime_error("Broker socket failed");
+
+           sockaddr_un addr;
+           std::memset(&addr, 0, sizeof(addr));
+           addr.sun_family = AF_UNIX;
+           std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+           if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) throw std::runtime_error("Broker connect failed");
+        }
+        catch (const std::runtime_error& e) {
+           std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+
+    ~BrokerClient() { if (fd >= 0) close(fd); }
+
+    BrokerClient(const BrokerClient &) = delete;
+    BrokerClient &operator=(const BrokerClient &) = delete;
+
+
+    int handle() const { return fd; }
+
+
+    bool subscribe(uint8_t dev, uint16_t mask) { return send({ BROKER_SUBSCRIBE, dev, 0, mask, 0 }); }
+
+    bool portWrite(uint8_t dev, uint16_t bits, uint16_t mask = 0xFFFF) { return send({ BROKER_WRITE, dev, bits, mask, 0 }); }
+
+    bool pinWrite(uint8_t dev, uint8_t pin, bool high) {
+        uint16_t bit = uint16_t(1) << (pin & 15);
+        return portWrite(dev, high ? bit : 0, bit);
+    }
+
+    // inputs = IODIR bits (1 = input), pullups = GPPU bits, both under mask.
+    bool config(uint8_t dev, uint16_t inputs, uint16_t pullups, uint16_t mask) {
+        return send({ BROKER_CONFIG, dev, inputs, mask, pullups });
+    }
+
+
+    // Blocks for the reply, events that arrive meanwhile are kept for readEvent().
+    bool snapshot(uint8_t dev, BrokerFrame &out, int timeoutMs = 1000) {
+        if (!send({ BROKER_SNAPSHOT, dev, 0, 0, 0 })) return false;
+        return reply(BROKER_SNAPSHOT, out, timeoutMs);
+    }
+
+
+    int devices(int timeoutMs = 1000) {
+        BrokerFrame f;
+        if (!send({ BROKER_INFO, 0, 0, 0, 0 }) || !reply(BROKER_INFO, f, timeoutMs)) return -1;
+        return f.dev;
+    }
+
+
+    // Next pin change of a subscribed device. Returns false on timeout.
+    bool readEvent(BrokerFrame &out, int timeoutMs = -1) {
+        if (!pending.empty()) {
+            out = pending.front();
+            pending.pop_front();
+            return true;
+        }
+        while (receive(out, timeoutMs)) {
+            if (out.op == BROKER_EVENT) return true;
+        }
+        return false;
+    }
+
+
+private:
+    int fd = -1;
+    std::deque<BrokerFrame> pending;
+
+    bool send(const BrokerFrame &f) {
+        return fd >= 0 && ::send(fd, &f, sizeof(f), MSG_NOSIGNAL) == sizeof(f);
+    }
+
+    bool receive(BrokerFrame &f, int timeoutMs) {
+        pollfd p = { fd, POLLIN, 0 };
+        if (fd < 0 || poll(&p, 1, timeoutMs) <= 0) return false;
+        return recv(fd, &f, sizeof(f), 0) == sizeof(f);
+    }
+
+    bool reply(uint8_t op, BrokerFrame &out, int timeoutMs) {
+        while (receive(out, timeoutMs)) {
+            if (out.op == op) return true;
+            if (out.op == BROKER_ERROR) return false;
+            if (out.op == BROKER_EVENT) pending.push_back(out);
+        }
+        return false;
+    }
+};
@@ -0,0 +1,299 @@
+/**
+ * @file MCP23017Co.hpp
+ * @brief C++20 coroutine awaitables for MCP23017 pin edges and port reads.
+ *
+ * CoService suspends coroutines on pin edges, port reads and input patterns and resumes them from
+ * one service loop. Each iteration waits on the host INT line (or the poll period), reads INTF, INTCAP
+ * and GPIO of every device with waiters in one transaction per bus, and resumes whoever is satisfied.
+ * A waiter is a few bytes in its coroutine frame, there is no thread per waiter.
+ * Needs C++20 (-std=c++20), the header is empty for older standards.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#pragma once
+
+#if __cplusplus >= 202002L
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <thread>
+
+#include "MCP23017.hpp"
+#include "MCP23017Int.hpp"
+
+struct CoEdge {
+    uint16_t pin;
+    pin_Value level;
+    uint64_t timestamp;  // CLOCK_MONOTONIC ns, the kernel edge time with a host INT line
+};
+
+
+// Fire-and-forget coroutine: runs until its first co_await right away and frees itself at the end.
+struct CoTask {
+    struct promise_type {
+        CoTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+
+/* CoService co(&line);              // or CoService co; to poll every 10 ms
+ * CoTask button(CoService &co) {
+ *     CoEdge e = co_await co.edge(mcp, 8, FALLING);
+ *     uint16_t port = co_await co.portReadAsync(mcp);
+ *     bool released = co_await co.waitFor(mcp, 0x0100, 0x0100, std::chrono::milliseconds(2000));
+ * }
+ * button(co); co.run(running);
+ */
+class CoService {
+public:
+
+    explicit CoService(HostIntLine *line = nullptr, std::chrono::milliseconds pollPeriod = std::chrono::milliseconds(10))
+        : line(line), period(pollPeriod) {}
+
+    CoService(const CoService &) = delete;
+    CoService &operator=(const CoService &) = delete;
+
+
+    struct Waiter {
+        CoService *svc;
+        MCP23017 *mcp;
+        uint8_t kind;
+        uint16_t mask;
+        uint16_t pattern;  // waitFor(): pattern, edge(): int_Mode
+        uint64_t deadline;
+        std::coroutine_handle<> handle{};
+        CoEdge edge{0, LOW, 0};
+        uint16_t value = 0;
+        bool matched = false;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { handle = h; svc->enqueue(this); }
+    };
+
+    struct EdgeAwait : Waiter {
+        CoEdge await_resume() const noexcept { return edge; }
+    };
+
+    struct ReadAwait : Waiter {
+        uint16_t await_resume() const noexcept { return value; }
+    };
+
+    struct WaitAwait : Waiter {
+        bool await_resume() const noexcept { return matched; }
+    };
+
+
+    // Next edge on pin. With a host INT line the pin is switched to interrupt on change, the direction is checked here.
+    EdgeAwait edge(MCP23017 &mcp, uint8_t pin, int_Mode mode = CHANGE) {
+        if (pin > 15) std::cerr << "Invalid input: edge(mcp, pin 0-15, mode)" << std::endl;
+        return { { this, &mcp, EDGE, uint16_t(1u << (pin & 15)), uint16_t(mode), 0 } };
+    }
+
+
+    // GPIOA/B, read together with all other due reads in the next transaction.
+    ReadAwait portReadAsync(MCP23017 &mcp) {
+        return { { this, &mcp, READ, 0xFFFF, 0, 0 } };
+    }
+
+
+    // Resumes with true once (GPIO & mask) == pattern, false after timeout (0 = no timeout).
+    WaitAwait waitFor(MCP23017 &mcp, uint16_t mask, uint16_t pattern, std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) {
+        uint64_t deadline = timeout.count() > 0 ? now() + uint64_t(timeout.count()) * 1000000ull : 0;
+        return { { this, &mcp, WAIT, mask, uint16_t(pattern & mask), deadline } };
+    }
+
+
+    size_t waiting() const {
+        size_t n = 0;
+        for (auto &d : devs) n += d.waiters.size();
+        return n;
+    }
+
+
+    /* One service iteration: wait for the INT line, the poll period or the next timeout,
+     * read all devices with waiters and resume the satisfied coroutines. Returns the number resumed.
+     */
+    size_t step() {
+        uint64_t t = now();
+        uint64_t next = 0;
+        bool read = false;
+        for (auto &d : devs) {
+            for (Waiter *w : d.waiters) {
+                if (w->kind == READ || (w->kind == WAIT && !d.known)) read = true;
+                if (w->deadline && (!next || w->deadline < next)) next = w->deadline;
+            }
+        }
+        if (!waiting()) return 0;
+
+        if (!read) {
+            int ms = next ? int(next > t ? (next - t + 999999) / 1000000 : 0) : -1;
+            if (line) {
+                read = line->isActive() || line->wait(ms);
+            } else {
+                int p = int(period.count());
+                std::this_thread::sleep_for(std::chrono::milliseconds(ms >= 0 && ms < p ? ms : p));
+                read = ms < 0 || ms >= p;
+            }
+        }
+        if (read && !readAll()) std::this_thread::sleep_for(period);  // Bus error, no busy retry
+        return dispatch();
+    }
+
+
+    void run(std::atomic<bool> &running) {
+        while (running) {
+            if (!waiting()) std::this_thread::sleep_for(period);
+            else step();
+        }
+    }
+
+
+private:
+    enum : uint8_t { EDGE, READ, WAIT };
+
+    struct Dev {
+        MCP23017 *mcp;
+        std::vector<Waiter *> waiters;
+        uint8_t regs[6];   // INTF, INTCAP, GPIO
+        uint16_t gpio;
+        uint16_t events;   // Pins with an edge in the last read
+        uint16_t levels;   // Their levels
+        uint16_t armed;    // Pins switched to interrupt on change
+        bool known;
+        bool fresh;        // Read in this iteration
+    };
+
+    HostIntLine *line;
+    std::chrono::milliseconds period;
+    std::vector<Dev> devs;
+    std::vector<Waiter *> ready;
+    I2CBurst burst;
+    I2CBurst rearm;
+
+    static uint64_t now() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+    }
+
+    void enqueue(Waiter *w) {
+        Dev *d = nullptr;
+        for (auto &x : devs) if (x.mcp == w->mcp) d = &x;
+        if (!d) {
+            devs.push_back({ w->mcp, {}, {0, 0, 0, 0, 0, 0}, 0, 0, 0, 0, false, false });
+            d = &devs.back();
+        }
+        d->waiters.push_back(w);
+
+        // Setup once per pin, outside the service path.
+        uint16_t arm = line && w->kind != READ ? uint16_t(w->mask & ~d->armed) : 0;
+        for (uint8_t pin = 0; pin < 16; pin++) {
+            if (!(arm & (1 << pin))) continue;
+            w->mcp->intTriggerMode(pin, CHANGE);
+            w->mcp->enableInt(pin);
+        }
+        d->armed |= arm;
+    }
+
+    // INTF, INTCAP and GPIO (six consecutive registers) of every device with waiters, one transaction per bus,
+    // followed by one re-arm transaction per bus if edge mode pins flagged.
+    bool readAll() {
+        bool ok = true;
+        std::vector<const std::string *> failed;
+        for (auto &d : devs) d.fresh = false;
+        for (size_t i = 0; i < devs.size(); i++) {
+            if (devs[i].fresh || devs[i].waiters.empty()) continue;
+            const std::string &bus = devs[i].mcp->device();
+            burst.clear();
+            for (size_t j = i; j < devs.size(); j++) {
+                if (devs[j].fresh || devs[j].waiters.empty() || devs[j].mcp->device() != bus) continue;
+                devs[j].mcp->burstRead(burst, MCP23017::INTFA, devs[j].regs, 6);
+                devs[j].fresh = true;
+            }
+            if (burst.run(devs[i].mcp->handle())) continue;
+            ok = false;
+            failed.push_back(&bus);
+        }
+
+        for (auto &d : devs) for (auto *bus : failed) if (d.mcp->device() == *bus) d.fresh = false;
+
+        // Edge mode pins keep INT asserted until DEFVAL follows the captured level,
+        // the re-arm of all devices on a bus goes out in one transaction.
+        std::vector<bool> parsed(devs.size(), false);
+        for (size_t i = 0; i < devs.size(); i++) {
+            if (!devs[i].fresh || parsed[i]) continue;
+            const std::string &bus = devs[i].mcp->device();
+            rearm.clear();
+            for (size_t j = i; j < devs.size(); j++) {
+                Dev &d = devs[j];
+                if (!d.fresh || parsed[j] || d.mcp->device() != bus) continue;
+                parsed[j] = true;
+                uint16_t raw      = (uint16_t(d.regs[1]) << 8) | d.regs[0];
+                uint16_t captured = (uint16_t(d.regs[3]) << 8) | d.regs[2];
+                uint16_t gpio     = (uint16_t(d.regs[5]) << 8) | d.regs[4];
+                uint16_t flags    = raw ? d.mcp->queueEdgeRearm(rearm, raw, captured) : 0;
+
+                // Captured edges first, then changes seen only by comparing GPIO (polling, or missed captures).
+                uint16_t changed = d.known ? uint16_t((gpio ^ d.gpio) & ~raw) : 0;
+                d.events = flags | changed;
+                d.levels = (captured & flags) | (gpio & changed);
+                d.gpio = gpio;
+                d.known = true;
+            }
+            if (!rearm.empty() && !rearm.run(devs[i].mcp->handle())) ok = false;
+        }
+        return ok;
+    }
+
+    size_t dispatch() {
+        uint64_t t = now();
+        uint64_t stamp = line && line->lastTimestamp() ? line->lastTimestamp() : t;
+        ready.clear();
+
+        for (auto &d : devs) {
+            size_t keep = 0;
+            for (Waiter *w : d.waiters) {
+                bool done = false;
+                if (d.fresh && w->kind == READ) {
+                    w->value = d.gpio;
+                    done = true;
+                } else if (d.fresh && w->kind == EDGE && (d.events & w->mask)) {
+                    bool high = d.levels & w->mask;
+                    if (w->pattern == CHANGE || (w->pattern == RISING) == high) {
+                        w->edge = { uint16_t(__builtin_ctz(w->mask)), high ? HIGH : LOW, stamp };
+                        done = true;
+                    }
+                } else if (w->kind == WAIT && d.known && (d.gpio & w->mask) == w->pattern) {
+                    w->matched = true;
+                    done = true;
+                }
+                if (!done && w->deadline && t >= w->deadline) done = true;
+
+                if (done) ready.push_back(w);
+                else d.waiters[keep++] = w;
+            }
+            d.waiters.resize(keep);
+            d.fresh = false;
+            d.events = 0;
+        }
+
+        // Resumed coroutines may await again, their new waiters go to the device lists, not to ready.
+        size_t n = ready.size();
+        for (size_t i = 0; i < n; i++) ready[i]->handle.resume();
+        return n;
+    }
+};
+
+#endif
@@ -0,0 +1,140 @@
+/**
+ * @file MCP23017Encoder.hpp
+ * @brief Quadrature decoder for rotary encoders on MCP23017 inputs.
+ *
+ * QuadratureDecoder turns A/B channel states into position counts with a table-driven state machine.
+ * It is fed with interrupt captures (INTF/INTCAP, optionally followed by the current GPIO) or with
+ * GPIO samples from a fast poll, and decodes all encoders of a device from the same port image.
+ * A jump over two states (both channels changed between two observations) is counted as an error.
+ * Positions and error counts are atomics and can be read from any thread.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+
+#include "MCP23017.hpp"
+
+/* QuadratureDecoder enc;
+ * size_t knob = enc.add(mcp, 0, 1);             // A on pin 0, B on pin 1, both INPUT_PULLUP with interrupt on change
+ * enc.feedSample(mcp, gpio);                    // Start state from one port read
+ * shared.add(mcp, [&](MCP23017 &m, const std::vector<IntEvent> &ev) { enc.feed(m, ev); });
+ * poll.add(mcp, 0x0003, std::chrono::microseconds(500), [&](uint16_t v) { enc.feedSample(mcp, v); });   // or polled
+ * int32_t pos = enc.position(knob);
+ */
+class QuadratureDecoder {
+public:
+
+    // Returns the encoder id. stepsPerDetent is 4 for most panel encoders (one full cycle per click).
+    size_t add(MCP23017 &mcp, uint8_t pinA, uint8_t pinB, uint8_t stepsPerDetent = 4) {
+        if (pinA > 15 || pinB > 15 || pinA == pinB) {
+            std::cerr << "Invalid input: add(mcp, pinA 0-15, pinB 0-15, steps)" << std::endl;
+            return SIZE_MAX;
+        }
+        Dev &d = device(mcp);
+        encoders.emplace_back(pinA, pinB, stepsPerDetent ? stepsPerDetent : 1);
+        d.encoders.push_back(encoders.size() - 1);
+        d.mask |= uint16_t((1u << pinA) | (1u << pinB));
+        return encoders.size() - 1;
+    }
+
+
+    /* INTF/INTCAP capture: INTCAP is the port at the first change, gpio (if read in the same
+     * transaction) the port now. Feeding both recovers one more transition per interrupt.
+     */
+    void feedCapture(MCP23017 &mcp, uint16_t flags, uint16_t captured, int32_t gpio = -1) {
+        Dev &d = device(mcp);
+        if (!(flags & d.mask)) return;
+        // Channels that did not flag keep their last known level, INTCAP of those pins may be stale.
+        step(d, (d.image & ~flags) | (captured & flags));
+        if (gpio >= 0) step(d, uint16_t(gpio));
+    }
+
+
+    // Events as delivered by SharedIntLine, SplitIntService or getIntCapture().
+    void feed(MCP23017 &mcp, const std::vector<IntEvent> &events) {
+        uint16_t flags = 0, captured = 0;
+        for (auto &e : events) {
+            flags |= uint16_t(1u << e.pin);
+            if (e.level) captured |= uint16_t(1u << e.pin);
+        }
+        feedCapture(mcp, flags, captured);
+    }
+
+
+    // GPIO port image from a poll.
+    void feedSample(MCP23017 &mcp, uint16_t gpio) { step(device(mcp), gpio); }
+
+
+    int32_t position(size_t id) const { return encoders[id].position.load(std::memory_order_relaxed); }
+
+    int32_t detents(size_t id) const { return position(id) / int32_t(encoders[id].steps); }
+
+    uint32_t errors(size_t id) const { return encoders[id].errors.load(std::memory_order_relaxed); }
+
+    void reset(size_t id, int32_t pos = 0) {
+        encoders[id].position.store(pos, std::memory_order_relaxed);
+        encoders[id].errors.store(0, std::memory_order_relaxed);
+    }
+
+    size_t size() const { return encoders.size(); }
+
+
+private:
+    struct Encoder {
+        Encoder(uint8_t a, uint8_t b, uint8_t steps) : pinA(a), pinB(b), steps(steps) {}
+
+        uint8_t pinA;
+        uint8_t pinB;
+        uint8_t steps;
+        uint8_t state = 0xFF;  // Last AB, 0xFF = not seen yet
+        std::atomic<int32_t> position{0};
+        std::atomic<uint32_t> errors{0};
+    };
+
+    struct Dev {
+        MCP23017 *mcp;
+        std::vector<size_t> encoders;
+        uint16_t mask;
+        uint16_t image;
+    };
+
+    // Index (last AB << 2) | new AB. Gray code order 00 -> 01 -> 11 -> 10 counts up, 2 = both channels changed.
+    static constexpr int8_t TABLE[16] = {
+         0, +1, -1,  2,
+        -1,  0,  2, +1,
+        +1,  2,  0, -1,
+         2, -1, +1,  0,
+    };
+
+    std::deque<Encoder> encoders;   // Atomics do not move, a deque never relocates them
+    std::vector<Dev> devs;
+
+    Dev &device(MCP23017 &mcp) {
+        for (auto &d : devs) if (d.mcp == &mcp) return d;
+        devs.push_back({ &mcp, {}, 0, 0 });
+        return devs.back();
+    }
+
+    void step(Dev &d, uint16_t image) {
+        d.image = image;
+        for (size_t id : d.encoders) {
+            Encoder &e = encoders[id];
+            uint8_t ab = uint8_t((((image >> e.pinA) & 1) << 1) | ((image >> e.pinB) & 1));
+            if (e.state != 0xFF) {
+                int8_t delta = TABLE[(e.state << 2) | ab];
+                if (delta == 2) e.errors.fetch_add(1, std::memory_order_relaxed);
+                else if (delta) e.position.fetch_add(delta, std::memory_order_relaxed);
+            }
+            e.state = ab;
+        }
+    }
+};
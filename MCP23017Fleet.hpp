@@ -0,0 +1,348 @@
+/**
+ * @file MCP23017Fleet.hpp
+ * @brief Fleet-wide port images and SIMD bit operations for large MCP23017 installations.
+ *
+ * FleetBits packs the 16 bit images of all devices into one aligned, contiguous bit array.
+ * Bitwise operations run over 256 pins per instruction with AVX2, 128 with SSE2 or NEON,
+ * with a 64 bit scalar fallback. FleetProgram applies the same rule to every device at once.
+ * FleetSnapshot finds changed inputs of the whole fleet with SIMD and only visits devices that changed.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+namespace fleet_simd {
+
+#if defined(__AVX2__)
+    static const char *const NAME = "AVX2";
+    using vec = __m256i;
+    inline vec load(const uint16_t *p)        { return _mm256_load_si256(reinterpret_cast<const __m256i *>(p)); }
+    inline void store(uint16_t *p, vec v)     { _mm256_store_si256(reinterpret_cast<__m256i *>(p), v); }
+    inline vec vand(vec a, vec b)             { return _mm256_and_si256(a, b); }
+    inline vec vor(vec a, vec b)              { return _mm256_or_si256(a, b); }
+    inline vec vxor(vec a, vec b)             { return _mm256_xor_si256(a, b); }
+    inline vec vandn(vec a, vec b)            { return _mm256_andnot_si256(b, a); }  // a & ~b
+    inline vec vnot(vec a)                    { return _mm256_xor_si256(a, _mm256_set1_epi32(-1)); }
+    inline bool zero(vec a)                   { return _mm256_testz_si256(a, a); }
+    constexpr unsigned STRIDE = 2;            // Bits per 16 bit lane in laneMask()
+    inline uint64_t laneMask(vec a)           { return ~uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi16(a, _mm256_setzero_si256()))); }
+#elif defined(__SSE2__)
+    static const char *const NAME = "SSE2";
+    using vec = __m128i;
+    inline vec load(const uint16_t *p)        { return _mm_load_si128(reinterpret_cast<const __m128i *>(p)); }
+    inline void store(uint16_t *p, vec v)     { _mm_store_si128(reinterpret_cast<__m128i *>(p), v); }
+    inline vec vand(vec a, vec b)             { return _mm_and_si128(a, b); }
+    inline vec vor(vec a, vec b)              { return _mm_or_si128(a, b); }
+    inline vec vxor(vec a, vec b)             { return _mm_xor_si128(a, b); }
+    inline vec vandn(vec a, vec b)            { return _mm_andnot_si128(b, a); }
+    inline vec vnot(vec a)                    { return _mm_xor_si128(a, _mm_set1_epi32(-1)); }
+    inline bool zero(vec a)                   { return _mm_movemask_epi8(_mm_cmpeq_epi8(a, _mm_setzero_si128())) == 0xFFFF; }
+    constexpr unsigned STRIDE = 2;
+    inline uint64_t laneMask(vec a)           { return uint16_t(~_mm_movemask_epi8(_mm_cmpeq_epi16(a, _mm_setzero_si128()))); }
+#elif defined(__ARM_NEON)
+    static const char *const NAME = "NEON";
+    using vec = uint16x8_t;
+    inline vec load(const uint16_t *p)        { return vld1q_u16(p); }
+    inline void store(uint16_t *p, vec v)     { vst1q_u16(p, v); }
+    inline vec vand(vec a, vec b)             { return vandq_u16(a, b); }
+    inline vec vor(vec a, vec b)              { return vorrq_u16(a, b); }
+    inline vec vxor(vec a, vec b)             { return veorq_u16(a, b); }
+    inline vec vandn(vec a, vec b)            { return vbicq_u16(a, b); }
+    inline vec vnot(vec a)                    { return vmvnq_u16(a); }
+    inline bool zero(vec a)                   { return vgetq_lane_u64(vreinterpretq_u64_u16(a), 0) == 0 && vgetq_lane_u64(vreinterpretq_u64_u16(a), 1) == 0; }
+    constexpr unsigned STRIDE = 8;
+    inline uint64_t laneMask(vec a)           { return vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(vtstq_u16(a, a))), 0); }
+#else
+    static const char *const NAME = "scalar";
+    using vec = uint64_t;
+    inline vec load(const uint16_t *p)        { vec v; std::memcpy(&v, p, sizeof(v)); return v; }
+    inline void store(uint16_t *p, vec v)     { std::memcpy(p, &v, sizeof(v)); }
+    inline vec vand(vec a, vec b)             { return a & b; }
+    inline vec vor(vec a, vec b)              { return a | b; }
+    inline vec vxor(vec a, vec b)             { return a ^ b; }
+    inline vec vandn(vec a, vec b)            { return a & ~b; }
+    inline vec vnot(vec a)                    { return ~a; }
+    inline bool zero(vec a)                   { return a == 0; }
+    constexpr unsigned STRIDE = 16;
+    inline uint64_t laneMask(vec a)           { return a; }
+#endif
+
+    constexpr size_t WORDS = sizeof(vec) / sizeof(uint16_t);
+}
+
+
+class FleetBits {
+public:
+    static constexpr size_t ALIGN_WORDS = 16;  // 256 bits, a multiple of every vector width
+
+    explicit FleetBits(size_t devices = 0) { resize(devices); }
+
+    FleetBits(const FleetBits &o) {
+        resize(o.count);
+        std::memcpy(words.get(), o.words.get(), padded * sizeof(uint16_t));
+    }
+
+    FleetBits &operator=(const FleetBits &o) {
+        if (this != &o) {
+            if (padded != o.padded) resize(o.count);
+            count = o.count;
+            std::memcpy(words.get(), o.words.get(), padded * sizeof(uint16_t));
+        }
+        return *this;
+    }
+
+    FleetBits(FleetBits &&) = default;
+    FleetBits &operator=(FleetBits &&) = default;
+
+
+    // Keeps the images of existing devices, new devices start at 0.
+    void resize(size_t devices) {
+        size_t p = (devices + ALIGN_WORDS - 1) / ALIGN_WORDS * ALIGN_WORDS;
+        if (p == 0) p = ALIGN_WORDS;
+        if (p != padded) {
+            Words w(static_cast<uint16_t *>(std::aligned_alloc(32, p * sizeof(uint16_t))));
+            std::memset(w.get(), 0, p * sizeof(uint16_t));
+            if (words) std::memcpy(w.get(), words.get(), (p < padded ? p : padded) * sizeof(uint16_t));
+            words = std::move(w);
+            padded = p;
+        }
+        count = devices;
+    }
+
+
+    size_t size() const { return count; }
+
+    size_t paddedSize() const { return padded; }
+
+    uint16_t *data() { return words.get(); }
+
+    const uint16_t *data() const { return words.get(); }
+
+    uint16_t &operator[](size_t dev) { return words[dev]; }
+
+    uint16_t operator[](size_t dev) const { return words[dev]; }
+
+    void fill(uint16_t v) { for (size_t i = 0; i < count; i++) words[i] = v; }
+
+
+    // dst = f(a, b) over the whole fleet, a and b must have the same size as dst.
+    template <class F>
+    static void map(FleetBits &dst, const FleetBits &a, const FleetBits &b, F f) {
+        uint16_t *d = dst.data();
+        const uint16_t *pa = a.data(), *pb = b.data();
+        for (size_t i = 0; i < dst.padded; i += fleet_simd::WORDS) {
+            fleet_simd::store(d + i, f(fleet_simd::load(pa + i), fleet_simd::load(pb + i)));
+        }
+    }
+
+    static void andOf(FleetBits &d, const FleetBits &a, const FleetBits &b)  { map(d, a, b, fleet_simd::vand); }
+    static void orOf(FleetBits &d, const FleetBits &a, const FleetBits &b)   { map(d, a, b, fleet_simd::vor); }
+    static void xorOf(FleetBits &d, const FleetBits &a, const FleetBits &b)  { map(d, a, b, fleet_simd::vxor); }
+    static void andNotOf(FleetBits &d, const FleetBits &a, const FleetBits &b) { map(d, a, b, fleet_simd::vandn); }
+
+    static void notOf(FleetBits &d, const FleetBits &a) {
+        map(d, a, a, [](fleet_simd::vec x, fleet_simd::vec) { return fleet_simd::vnot(x); });
+    }
+
+    // d = (d & ~mask) | (a & mask)
+    static void merge(FleetBits &d, const FleetBits &a, const FleetBits &mask) {
+        uint16_t *pd = d.data();
+        const uint16_t *pa = a.data(), *pm = mask.data();
+        for (size_t i = 0; i < d.padded; i += fleet_simd::WORDS) {
+            fleet_simd::vec m = fleet_simd::load(pm + i);
+            fleet_simd::store(pd + i, fleet_simd::vor(fleet_simd::vandn(fleet_simd::load(pd + i), m),
+                                                      fleet_simd::vand(fleet_simd::load(pa + i), m)));
+        }
+    }
+
+
+    // f(dev, word) for every non-zero word, all-zero vectors are skipped without looking at their words.
+    template <class F>
+    size_t forEachNonZero(F f) const {
+        static constexpr uint64_t laneBits = fleet_simd::STRIDE == 64 ? ~0ull : (1ull << fleet_simd::STRIDE) - 1;
+        const uint16_t *d = words.get();
+        size_t n = 0;
+
+        for (size_t i = 0; i < padded; i += fleet_simd::WORDS) {
+            fleet_simd::vec v = fleet_simd::load(d + i);
+            if (fleet_simd::zero(v)) continue;
+
+            for (uint64_t m = fleet_simd::laneMask(v); m; ) {
+                unsigned lane = unsigned(__builtin_ctzll(m)) / fleet_simd::STRIDE;
+                m &= ~(laneBits << (lane * fleet_simd::STRIDE));
+                f(i + lane, d[i + lane]);
+                n++;
+            }
+        }
+        return n;
+    }
+
+
+    bool any() const {
+        for (size_t i = 0; i < padded; i += fleet_simd::WORDS) {
+            if (!fleet_simd::zero(fleet_simd::load(words.get() + i))) return true;
+        }
+        return false;
+    }
+
+
+private:
+    struct Free {
+        void operator()(uint16_t *p) const { std::free(p); }
+    };
+    using Words = std::unique_ptr<uint16_t[], Free>;
+
+    Words words;
+    size_t padded = 0;
+    size_t count = 0;
+};
+
+
+enum fleet_Op : uint8_t { FLEET_LOAD, FLEET_AND, FLEET_OR, FLEET_XOR, FLEET_ANDN, FLEET_NOT, FLEET_STORE };
+
+/* Same rule for every device, evaluated over the whole fleet image.
+ * Image 0 = inputs, image 1 = outputs, further images are constants added with constant().
+ *   FleetProgram p;
+ *   uint16_t enable = p.constant(enableMasks);
+ *   p.load(FleetProgram::INPUTS).andNot(FleetProgram::OUTPUTS).store(enable);
+ */
+class FleetProgram {
+public:
+    static constexpr uint16_t INPUTS = 0;
+    static constexpr uint16_t OUTPUTS = 1;
+
+    uint16_t constant(const FleetBits &image) {
+        constants.push_back(image);
+        return uint16_t(constants.size() + 1);
+    }
+
+    FleetProgram &load(uint16_t image)    { ops.push_back({ FLEET_LOAD, image }); return *this; }
+    FleetProgram &andWith(uint16_t image) { ops.push_back({ FLEET_AND, image }); return *this; }
+    FleetProgram &orWith(uint16_t image)  { ops.push_back({ FLEET_OR, image }); return *this; }
+    FleetProgram &xorWith(uint16_t image) { ops.push_back({ FLEET_XOR, image }); return *this; }
+    FleetProgram &andNot(uint16_t image)  { ops.push_back({ FLEET_ANDN, image }); return *this; }
+    FleetProgram &invert()                { ops.push_back({ FLEET_NOT, 0 }); return *this; }
+
+    // outputs = accumulator under the mask image, other output bits keep their value.
+    FleetProgram &store(uint16_t maskImage) { ops.push_back({ FLEET_STORE, maskImage }); return *this; }
+
+
+    bool valid(size_t devices) const {
+        for (auto &op : ops) {
+            if (op.op != FLEET_NOT && op.image > constants.size() + 1) return false;
+        }
+        for (auto &c : constants) if (c.size() != devices) return false;
+        return true;
+    }
+
+
+    void evaluate(const FleetBits &inputs, FleetBits &outputs) {
+        if (acc.size() != inputs.size()) acc.resize(inputs.size());
+
+        for (auto &op : ops) {
+            const FleetBits &v = op.image == INPUTS ? inputs : op.image == OUTPUTS ? outputs : constants[op.image - 2];
+            switch (op.op) {
+                case FLEET_LOAD:  acc = v; break;
+                case FLEET_AND:   FleetBits::andOf(acc, acc, v); break;
+                case FLEET_OR:    FleetBits::orOf(acc, acc, v); break;
+                case FLEET_XOR:   FleetBits::xorOf(acc, acc, v); break;
+                case FLEET_ANDN:  FleetBits::andNotOf(acc, acc, v); break;
+                case FLEET_NOT:   FleetBits::notOf(acc, acc); break;
+                case FLEET_STORE: FleetBits::merge(outputs, acc, v); break;
+            }
+        }
+    }
+
+
+private:
+    struct Op {
+        fleet_Op op;
+        uint16_t image;
+    };
+
+    std::vector<Op> ops;
+    std::vector<FleetBits> constants;
+    FleetBits acc;
+};
+
+
+struct FleetEvent {
+    uint32_t dev;
+    uint16_t pin;
+    bool level;
+};
+
+
+/* Previous and current input images of all devices. Write new images with set() or current(),
+ * then changes() visits only devices whose image changed and only their changed pins.
+ */
+class FleetSnapshot {
+public:
+
+    explicit FleetSnapshot(size_t devices = 0) { resize(devices); }
+
+    void resize(size_t devices) {
+        prev.resize(devices);
+        cur.resize(devices);
+        delta.resize(devices);
+    }
+
+    size_t size() const { return cur.size(); }
+
+    void set(size_t dev, uint16_t image) { cur[dev] = image; }
+
+    FleetBits &current() { return cur; }
+
+    const FleetBits &previous() const { return prev; }
+
+
+    /* f(dev, changedMask, image) for every device with a change, then current becomes previous.
+     * Returns the number of changed devices.
+     */
+    template <class F>
+    size_t changedDevices(F f) {
+        FleetBits::xorOf(delta, cur, prev);
+        size_t n = delta.forEachNonZero([&](size_t dev, uint16_t changed) { f(dev, changed, cur[dev]); });
+        prev = cur;
+        return n;
+    }
+
+
+    // f(FleetEvent) for every changed pin. Returns the number of events.
+    template <class F>
+    size_t changes(F f) {
+        size_t n = 0;
+        changedDevices([&](size_t dev, uint16_t changed, uint16_t image) {
+            for (uint32_t m = changed; m; m &= m - 1) {
+                uint16_t pin = uint16_t(__builtin_ctz(m));
+                f(FleetEvent{ uint32_t(dev), pin, bool((image >> pin) & 1) });
+                n++;
+            }
+        });
+        return n;
+    }
+
+
+private:
+    FleetBits prev, cur, delta;
+};
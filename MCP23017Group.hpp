@@ -0,0 +1,303 @@
+/**
+ * @file MCP23017Group.hpp
+ * @brief Synchronized output update for several MCP23017 expanders.
+ *
+ * Collects pin and port writes for any number of devices and commits them together.
+ * All OLAT writes for the devices on one bus go out back to back in a single I2C_RDWR
+ * transaction, several buses are committed concurrently.
+ * PinGroup maps a logical value onto pins spread over several expanders and writes or reads it in one batch.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <thread>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "MCP23017.hpp"
+
+struct GroupReport {
+    size_t buses = 0;
+    size_t devices = 0;
+    std::chrono::nanoseconds busTime{0};  // Longest write ioctl on one bus, incl. kernel and scheduling delays
+    std::chrono::nanoseconds busSkew{0};  // Spread of the write start times between buses
+    bool ok = true;
+};
+
+class MCP23017Group {
+public:
+
+    void pinWrite(MCP23017 &mcp, uint8_t pin, pin_Value value) {
+        if (pin > 15 || (value != HIGH && value != LOW)) {
+            std::cerr << "Invalid input: pinWrite(mcp, pin 0-15, HIGH/LOW)" << std::endl;
+            return;
+        }
+        uint16_t bit = uint16_t(1) << pin;
+        portWrite(mcp, value == HIGH ? bit : 0, bit);
+    }
+
+
+    void portWrite(MCP23017 &mcp, uint16_t bits, uint16_t mask = 0xFFFF) {
+        Pending &p = find(mcp);
+        p.bits = (p.bits & ~mask) | (bits & mask);
+        p.mask |= mask;
+    }
+
+
+    GroupReport commit() {
+        std::map<std::string, std::vector<Pending *>> buses;
+        for (auto &p : pending) buses[p.mcp->device()].push_back(&p);
+
+        GroupReport report;
+        report.buses = buses.size();
+        report.devices = pending.size();
+
+        std::vector<BusResult> results(buses.size());
+        std::vector<std::thread> workers;
+        size_t i = 0;
+        for (auto &bus : buses) {
+            if (i + 1 < buses.size()) workers.emplace_back(&MCP23017Group::commitBus, std::ref(bus.second), std::ref(results[i]));
+            else commitBus(bus.second, results[i]);
+            i++;
+        }
+        for (auto &w : workers) w.join();
+
+        if (!results.empty()) {
+            auto first = results[0].start, last = results[0].start;
+            for (auto &r : results) {
+                report.ok &= r.ok;
+                if (r.end - r.start > report.busTime) report.busTime = r.end - r.start;
+                if (r.start < first) first = r.start;
+                if (r.start > last) last = r.start;
+            }
+            report.busSkew = last - first;
+        }
+
+        pending.clear();
+        return report;
+    }
+
+
+    void discard() { pending.clear(); }
+
+    size_t size() const { return pending.size(); }
+
+
+private:
+    struct Pending {
+        MCP23017 *mcp;
+        uint16_t bits;
+        uint16_t mask;
+        uint8_t olat[2];
+    };
+
+    struct BusResult {
+        std::chrono::steady_clock::time_point start{}, end{};
+        bool ok = true;
+    };
+
+    std::vector<Pending> pending;
+
+    Pending &find(MCP23017 &mcp) {
+        for (auto &p : pending) if (p.mcp == &mcp) return p;
+        pending.push_back({ &mcp, 0, 0, {0, 0} });
+        return pending.back();
+    }
+
+    // Read the latches of partly written devices in one burst, then write all latches in one burst.
+    static void commitBus(std::vector<Pending *> &devs, BusResult &result) {
+        int fd = devs.front()->mcp->handle();
+        I2CBurst burst;
+
+        for (auto *p : devs) {
+            if ((p->mask & 0x00FF) != 0x00FF && (p->mask & 0x00FF)) p->mcp->burstRead(burst, MCP23017::OLATA, &p->olat[0], 1);
+            if ((p->mask & 0xFF00) != 0xFF00 && (p->mask & 0xFF00)) p->mcp->burstRead(burst, MCP23017::OLATB, &p->olat[1], 1);
+        }
+        if (!burst.empty() && !burst.run(fd)) {
+            result.ok = false;
+            return;
+        }
+
+        burst.clear();
+        for (auto *p : devs) {
+            uint16_t cur = (uint16_t(p->olat[1]) << 8) | p->olat[0];
+            uint16_t val = (cur & ~p->mask) | (p->bits & p->mask);
+            p->olat[0] = uint8_t(val);
+            p->olat[1] = uint8_t(val >> 8);
+
+            bool a = p->mask & 0x00FF, b = p->mask & 0xFF00;
+            if (a && b) p->mcp->burstWrite(burst, MCP23017::OLATA, p->olat, 2);
+            else if (a) p->mcp->burstWrite(burst, MCP23017::OLATA, &p->olat[0], 1);
+            else if (b) p->mcp->burstWrite(burst, MCP23017::OLATB, &p->olat[1], 1);
+        }
+
+        result.start = std::chrono::steady_clock::now();
+        result.ok = burst.run(fd);
+        result.end = std::chrono::steady_clock::now();
+    }
+};
+
+
+// Bit scatter/gather: BMI2 PEXT/PDEP when compiled with -mbmi2 (or -march=native), otherwise a loop over the mask bits.
+namespace pin_bits {
+#if defined(__BMI2__)
+    inline uint32_t pext(uint32_t v, uint32_t m) { return _pext_u32(v, m); }
+    inline uint32_t pdep(uint32_t v, uint32_t m) { return _pdep_u32(v, m); }
+#else
+    inline uint32_t pext(uint32_t v, uint32_t m) {
+        uint32_t r = 0;
+        for (uint32_t b = 1; m; m &= m - 1, b <<= 1) if (v & m & (0u - m)) r |= b;
+        return r;
+    }
+
+    inline uint32_t pdep(uint32_t v, uint32_t m) {
+        uint32_t r = 0;
+        for (uint32_t b = 1; m; m &= m - 1, b <<= 1) if (v & b) r |= m & (0u - m);
+        return r;
+    }
+#endif
+}
+
+
+/* Logical value of up to 32 bits whose bits sit on pins of different expanders, LSB first:
+ *   PinGroup data; data.add(mcp1, 0).add(mcp1, 1).add(mcp2, 8) ...; data.write(0x5A3); data.read(value);
+ * The pins of one device form slices with ascending pin numbers, so each slice moves with one PEXT and one PDEP.
+ */
+class PinGroup {
+public:
+
+    PinGroup &add(MCP23017 &mcp, uint8_t pin) {
+        if (pin > 15 || bits >= 32) {
+            std::cerr << "Invalid input: PinGroup add(mcp, pin 0-15), at most 32 pins" << std::endl;
+            return *this;
+        }
+        uint16_t bit = uint16_t(1) << pin;
+        uint16_t d = 0;
+        while (d < devs.size() && devs[d].mcp != &mcp) d++;
+        if (d == devs.size()) devs.push_back({ &mcp, 0, 0, 0, {0, 0}, {0, 0} });
+        if (devs[d].mask & bit) {
+            std::cerr << "Invalid input: PinGroup pin " << int(pin) << " used twice" << std::endl;
+            return *this;
+        }
+        devs[d].mask |= bit;
+
+        // A pin below the highest pin of the device's last slice starts a new slice.
+        Slice *s = nullptr;
+        for (auto &sl : slices) if (sl.dev == d) s = &sl;
+        if (!s || s->pins > bit) {
+            slices.push_back({ d, 0, 0 });
+            s = &slices.back();
+        }
+        s->logical |= uint32_t(1) << bits;
+        s->pins |= bit;
+        bits++;
+        prepared = false;
+        return *this;
+    }
+
+
+    uint8_t width() const { return bits; }
+
+
+    /* Scatters value into the latches: one OLAT read for ports with foreign pins,
+     * then one masked write per touched port, each as one transaction per bus.
+     */
+    bool write(uint32_t value) {
+        if (!prepared) prepare();
+        for (auto &d : devs) d.bits = 0;
+        for (auto &s : slices) devs[s.dev].bits |= uint16_t(pin_bits::pdep(pin_bits::pext(value, s.logical), s.pins));
+
+        bool ok = true;
+        for (auto &b : buses) if (!b.latch.empty()) ok &= b.latch.run(b.mcp->handle());
+        if (!ok) return false;
+
+        for (auto &b : buses) b.write.clear();
+        for (auto &d : devs) {
+            uint16_t cur = word(d.olat);
+            uint16_t val = (cur & ~d.mask) | (d.bits & d.mask);
+            d.olat[0] = uint8_t(val);
+            d.olat[1] = uint8_t(val >> 8);
+
+            bool a = d.mask & 0x00FF, hi = d.mask & 0xFF00;
+            if (a && hi) d.mcp->burstWrite(buses[d.bus].write, MCP23017::OLATA, d.olat, 2);
+            else if (a) d.mcp->burstWrite(buses[d.bus].write, MCP23017::OLATA, &d.olat[0], 1);
+            else d.mcp->burstWrite(buses[d.bus].write, MCP23017::OLATB, &d.olat[1], 1);
+        }
+        for (auto &b : buses) ok &= b.write.run(b.mcp->handle());
+        return ok;
+    }
+
+
+    // Gathers the value from one GPIO read of all touched ports per bus. Returns false and leaves value on a bus error.
+    bool read(uint32_t &value) {
+        if (!prepared) prepare();
+        for (auto &b : buses) if (!b.read.run(b.mcp->handle())) return false;
+
+        uint32_t v = 0;
+        for (auto &s : slices) v |= pin_bits::pdep(pin_bits::pext(word(devs[s.dev].gpio), s.pins), s.logical);
+        value = v;
+        return true;
+    }
+
+
+private:
+    struct Dev {
+        MCP23017 *mcp;
+        uint16_t mask;   // Pins of this group
+        uint16_t bits;   // Scattered value
+        size_t bus;
+        uint8_t olat[2];
+        uint8_t gpio[2];
+    };
+
+    struct Slice {
+        uint16_t dev;
+        uint32_t logical;  // Bits of the logical value
+        uint16_t pins;     // Pins they go to, same order
+    };
+
+    struct Bus {
+        MCP23017 *mcp;   // First device on the bus path, its fd runs the transactions
+        I2CBurst latch;
+        I2CBurst write;
+        I2CBurst read;
+    };
+
+    std::vector<Dev> devs;
+    std::vector<Slice> slices;
+    std::vector<Bus> buses;
+    uint8_t bits = 0;
+    bool prepared = false;
+
+    static uint16_t word(const uint8_t *r) { return (uint16_t(r[1]) << 8) | r[0]; }
+
+    // The read bursts point at fixed buffers, so they are built once.
+    void prepare() {
+        buses.clear();
+        for (auto &d : devs) {
+            d.bus = 0;
+            while (d.bus < buses.size() && buses[d.bus].mcp->device() != d.mcp->device()) d.bus++;
+            if (d.bus == buses.size()) buses.push_back({ d.mcp, I2CBurst(), I2CBurst(), I2CBurst() });
+            Bus *b = &buses[d.bus];
+
+            bool a = d.mask & 0x00FF, hi = d.mask & 0xFF00;
+            uint8_t reg = a ? 0 : 1, len = (a && hi) ? 2 : 1;
+
+            if (a && (d.mask & 0x00FF) != 0x00FF) d.mcp->burstRead(b->latch, MCP23017::OLATA, &d.olat[0], 1);
+            if (hi && (d.mask & 0xFF00) != 0xFF00) d.mcp->burstRead(b->latch, MCP23017::OLATB, &d.olat[1], 1);
+            d.mcp->burstRead(b->read, uint8_t(MCP23017::GPIOA + reg), &d.gpio[reg], len);
+        }
+        prepared = true;
+    }
+};
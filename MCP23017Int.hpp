@@ -0,0 +1,595 @@
+/**
+ * @file MCP23017Int.hpp
+ * @brief Interrupt service for MCP23017 expanders wired to host GPIO lines.
+ *
+ * HostIntLine waits on a host GPIO (Linux GPIO character device) that is driven by INTA/INTB.
+ * SharedIntLine serves all chips whose open-drain INT outputs share one host line:
+ * INTF and INTCAP of every chip are read in one I2C transaction and only chips that flagged are dispatched.
+ * SplitIntService serves one chip with separate INTA/INTB lines and only reads the port that fired.
+ * IntCascade resolves trees of chips whose INT outputs feed input pins of an upstream chip.
+ * IntWaiter blocks until a pin reaches a level or any pin of a mask changes, woken by the host line.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <poll.h>
+#include <linux/gpio.h>
+#include <thread>
+
+#include "MCP23017.hpp"
+
+
+inline std::vector<IntEvent> intEvents(uint16_t flags, uint16_t captured) {
+    std::vector<IntEvent> events;
+    for (uint16_t pin = 0; pin < 16; pin++) {
+        if (flags & (1 << pin)) events.push_back({ pin, bool(captured & (1 << pin)) });
+    }
+    return events;
+}
+
+
+// Milliseconds left until end for poll(), -1 (forever) if timeoutMs < 0.
+inline int intRemainingMs(std::chrono::steady_clock::time_point end, int timeoutMs) {
+    if (timeoutMs < 0) return -1;
+    auto left = std::chrono::ceil<std::chrono::milliseconds>(end - std::chrono::steady_clock::now()).count();
+    return left > 0 ? int(left) : 0;
+}
+
+
+struct IntBusStats {
+    uint64_t transactions = 0;
+    uint64_t errors = 0;
+    uint64_t bytes = 0;   // Wire bytes incl. addresses
+    uint64_t stuck = 0;   // Times the line stayed asserted with no chip flagged
+};
+
+
+struct IntWaitResult {
+    bool ok;             // false on timeout or bus error
+    uint16_t pin;
+    pin_Value level;
+    uint64_t timestamp;  // CLOCK_MONOTONIC ns, the kernel edge time with a host INT line
+};
+
+
+class HostIntLine {
+public:
+
+    /* line   = Line offset on the GPIO chip
+     * active = LOW for open-drain or INTPOL low, HIGH for INTPOL high
+     * pullup = Use the host pull-up, for open-drain INT without external resistor
+     */
+    HostIntLine(unsigned line, const std::string &chip = "/dev/gpiochip0", pin_Value active = LOW, bool pullup = false)
+        : activeLow(active == LOW) {
+        int chipFd = open(chip.c_str(), O_RDONLY);
+
+        try {
+           if (chipFd < 0) throw std::runtime_error("GPIO chip open failed");
+
+           gpio_v2_line_request req;
+           std::memset(&req, 0, sizeof(req));
+           req.offsets[0] = line;
+           req.num_lines = 1;
+           std::strncpy(req.consumer, "mcp23017", sizeof(req.consumer) - 1);
+           req.config.flags = GPIO_V2_LINE_FLAG_INPUT
+                            | (activeLow ? GPIO_V2_LINE_FLAG_EDGE_FALLING : GPIO_V2_LINE_FLAG_EDGE_RISING)
+                            | (pullup ? GPIO_V2_LINE_FLAG_BIAS_PULL_UP : 0);
+
+           if (ioctl(chipFd, GPIO_V2_GET_LINE_IOCTL, &req) < 0) throw std::runtime_error("GPIO line request failed");
+           fd = req.fd;
+        }
+        catch (const std::runtime_error& e) {
+           std::cerr << "Error: " << e.what() << std::endl;
+        }
+        if (chipFd >= 0) close(chipFd);
+    }
+
+    ~HostIntLine() { if (fd >= 0) close(fd); }
+
+    HostIntLine(const HostIntLine &) = delete;
+    HostIntLine &operator=(const HostIntLine &) = delete;
+
+
+    int handle() const { return fd; }
+
+
+    // INT is still asserted, e.g. another chip on a wired-OR line has flagged in the meantime.
+    bool isActive() const {
+        gpio_v2_line_values values = { 0, 1 };
+        if (fd < 0 || ioctl(fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0) return false;
+        return bool(values.bits & 1) != activeLow;
+    }
+
+
+    // Blocks until an edge arrives, timeoutMs < 0 waits forever. Returns false on timeout.
+    bool wait(int timeoutMs = -1) {
+        pollfd p = { fd, POLLIN, 0 };
+        if (fd < 0 || poll(&p, 1, timeoutMs) <= 0) return false;
+        return readEvent();
+    }
+
+
+    // Consumes one pending edge event, lastTimestamp() then holds its kernel timestamp.
+    bool readEvent() {
+        gpio_v2_line_event event;
+        if (read(fd, &event, sizeof(event)) != sizeof(event)) return false;
+        timestamp = event.timestamp_ns;
+        return true;
+    }
+
+
+    // Consumes all queued edge events without blocking, e.g. those of flags that were just serviced.
+    size_t drain() {
+        size_t n = 0;
+        pollfd p = { fd, POLLIN, 0 };
+        while (fd >= 0 && poll(&p, 1, 0) > 0 && readEvent()) n++;
+        return n;
+    }
+
+
+    // CLOCK_MONOTONIC nanoseconds of the last edge.
+    uint64_t lastTimestamp() const { return timestamp; }
+
+
+private:
+    int fd = -1;
+    bool activeLow;
+    uint64_t timestamp = 0;
+};
+
+
+class SharedIntLine {
+public:
+    using Handler = std::function<void(MCP23017 &, const std::vector<IntEvent> &)>;
+
+    explicit SharedIntLine(HostIntLine *line = nullptr) : line(line) {}
+
+
+    void add(MCP23017 &mcp, Handler handler) {
+        if (!chips.empty() && chips.front().mcp->device() != mcp.device()) {
+            std::cerr << "Invalid input: all chips on a shared INT line must be on the same bus" << std::endl;
+            return;
+        }
+        chips.push_back({ &mcp, std::move(handler), 0, {0, 0, 0, 0}, 0, 0 });
+        order.push_back(chips.size() - 1);
+    }
+
+
+    /* Reads INTFA/B and INTCAPA/B of every chip in one transaction, which also releases their INT outputs.
+     * Chips that fire most often are probed and dispatched first.
+     * Returns the number of chips that had flagged.
+     */
+    size_t service() {
+        if (chips.empty()) return 0;
+
+        burst.clear();
+        for (size_t i : order) chips[i].mcp->burstRead(burst, MCP23017::INTFA, chips[i].regs, 4);
+        if (!run(burst)) return 0;
+
+        rearm.clear();
+        for (size_t i : order) {
+            Chip &c = chips[i];
+            c.flags    = (uint16_t(c.regs[1]) << 8) | c.regs[0];
+            c.captured = (uint16_t(c.regs[3]) << 8) | c.regs[2];
+            c.score   -= c.score / 8;
+            if (c.flags) c.flags = c.mcp->queueEdgeRearm(rearm, c.flags, c.captured);
+        }
+        if (!rearm.empty()) run(rearm);
+
+        size_t fired = 0;
+        for (size_t i : order) {
+            Chip &c = chips[i];
+            uint16_t flags = c.flags, captured = c.captured;
+            if (!flags) continue;
+
+            c.score += 32;
+            fired++;
+            if (c.handler) c.handler(*c.mcp, intEvents(flags, captured));
+        }
+
+        std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return chips[a].score > chips[b].score;
+        });
+        return fired;
+    }
+
+
+    /* Waits for the host line and services until it is released again.
+     * The edge events of the serviced flags are consumed, an edge without flags does not end the wait.
+     * A line that stays asserted with no chip flagged is reported once and then re-probed with
+     * a back-off of up to 100 ms instead of saturating the bus.
+     * Returns the number of chips dispatched, 0 on timeout.
+     */
+    size_t wait(int timeoutMs = -1) {
+        if (!line) {
+            std::cerr << "Invalid input: SharedIntLine has no HostIntLine" << std::endl;
+            return 0;
+        }
+        auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        int backoffMs = 0;
+
+        while (true) {
+            if (backoffMs) {
+                int left = intRemainingMs(end, timeoutMs);
+                line->wait(left < 0 ? backoffMs : std::min(left, backoffMs));
+            } else if (!line->isActive() && !line->wait(intRemainingMs(end, timeoutMs))) return 0;
+
+            size_t fired = 0;
+            for (int round = 0; round < 8; round++) {
+                fired += service();
+                if (!line->isActive()) break;
+            }
+            line->drain();
+            if (fired || (timeoutMs >= 0 && std::chrono::steady_clock::now() >= end)) return fired;
+
+            if (!line->isActive()) backoffMs = 0;
+            else if (backoffMs) backoffMs = std::min(backoffMs * 2, 100);
+            else {
+                stat.stuck++;
+                backoffMs = 1;
+                std::cerr << "Error: shared INT line held with no chip flagged" << std::endl;
+            }
+        }
+    }
+
+
+    // Transactions of service() so far, e.g. for the bus counters of a shared memory mirror.
+    const IntBusStats &busStats() const { return stat; }
+
+
+private:
+    struct Chip {
+        MCP23017 *mcp;
+        Handler handler;
+        uint32_t score;
+        uint8_t regs[4];
+        uint16_t flags;
+        uint16_t captured;
+    };
+
+    HostIntLine *line;
+    std::vector<Chip> chips;
+    std::vector<size_t> order;
+    I2CBurst burst;
+    I2CBurst rearm;
+    IntBusStats stat;
+
+    bool run(I2CBurst &b) {
+        bool ok = b.run(chips.front().mcp->handle());
+        stat.transactions++;
+        stat.bytes += b.wireBytes();
+        if (!ok) stat.errors++;
+        return ok;
+    }
+};
+
+
+class SplitIntService {
+public:
+
+    // Requires intOutputMode(..., w_MIRROR = false), INTA on lineA and INTB on lineB.
+    SplitIntService(MCP23017 &mcp, HostIntLine &lineA, HostIntLine &lineB) : mcp(mcp), lineA(lineA), lineB(lineB) {}
+
+
+    /* Reads INTF and INTCAP of the given ports, which also releases their INT outputs.
+     * A single port touches only its own two registers, both ports are read in one combined burst.
+     */
+    std::vector<IntEvent> service(bool portA, bool portB) {
+        uint8_t regs[4] = {0, 0, 0, 0};
+
+        burst.clear();
+        if (portA && portB) {
+            mcp.burstRead(burst, MCP23017::INTFA, regs, 4);
+        } else if (portA) {
+            mcp.burstRead(burst, MCP23017::INTFA, &regs[0], 1);
+            mcp.burstRead(burst, MCP23017::INTCAPA, &regs[2], 1);
+        } else if (portB) {
+            mcp.burstRead(burst, MCP23017::INTFB, &regs[1], 1);
+            mcp.burstRead(burst, MCP23017::INTCAPB, &regs[3], 1);
+        }
+        if (burst.empty() || !burst.run(mcp.handle())) return {};
+
+        uint16_t flags    = (uint16_t(regs[1]) << 8) | regs[0];
+        uint16_t captured = (uint16_t(regs[3]) << 8) | regs[2];
+
+        burst.clear();
+        flags = mcp.queueEdgeRearm(burst, flags, captured);
+        if (!burst.empty()) burst.run(mcp.handle());
+
+        return intEvents(flags, captured);
+    }
+
+
+    /* Waits for INTA and/or INTB and serves whatever is asserted. Queued edges of the served ports are
+     * consumed, an edge without flags does not end the wait. Empty on timeout.
+     */
+    std::vector<IntEvent> wait(int timeoutMs = -1) {
+        auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+        while (true) {
+            bool a = lineA.isActive(), b = lineB.isActive();
+
+            if (!a && !b) {
+                pollfd p[2] = { { lineA.handle(), POLLIN, 0 }, { lineB.handle(), POLLIN, 0 } };
+                if (poll(p, 2, intRemainingMs(end, timeoutMs)) <= 0) return {};
+                if (p[0].revents & POLLIN) a = lineA.readEvent();
+                if (p[1].revents & POLLIN) b = lineB.readEvent();
+                a = a || lineA.isActive();
+                b = b || lineB.isActive();
+            }
+            std::vector<IntEvent> events = service(a, b);
+            if (a) lineA.drain();
+            if (b) lineB.drain();
+            if (!events.empty() || (timeoutMs >= 0 && std::chrono::steady_clock::now() >= end)) return events;
+        }
+    }
+
+
+private:
+    MCP23017 &mcp;
+    HostIntLine &lineA;
+    HostIntLine &lineB;
+    I2CBurst burst;
+};
+
+
+class IntCascade {
+public:
+    using Handler = std::function<void(MCP23017 &, const std::vector<IntEvent> &)>;
+
+    explicit IntCascade(MCP23017 &root, Handler handler = nullptr) {
+        nodes.push_back({ &root, std::move(handler), {}, {0, 0, 0, 0}, {0, 0} });
+    }
+
+
+    /* child INT output is wired to parentPin of parent, parent must already be in the tree.
+     * active = LOW for open-drain or INTPOL low children.
+     * The parent pin is set up as a compare interrupt against the idle level (see setPatternAlarm),
+     * so the parent keeps flagging until the child has been cleared.
+     */
+    void add(MCP23017 &child, MCP23017 &parent, uint8_t parentPin, Handler handler = nullptr, pin_Value active = LOW) {
+        size_t p = indexOf(parent);
+        if (p == npos || parentPin > 15 || indexOf(child) != npos) {
+            std::cerr << "Invalid input: add(child, parent in tree, parentPin 0-15)" << std::endl;
+            return;
+        }
+
+        uint16_t bit = uint16_t(1) << parentPin;
+        parent.pinMode(parentPin, active == LOW ? INPUT_PULLUP : INPUT);
+        parent.setPatternAlarm(active == LOW ? bit : 0, bit);
+
+        nodes.push_back({ &child, std::move(handler), {}, {0, 0, 0, 0}, {0, 0} });
+        nodes[p].children.push_back({ parentPin, nodes.size() - 1 });
+    }
+
+
+    /* Walks only flagged branches, one batched INTF/INTCAP read per tree level and bus,
+     * then clears all visited chips from the leaves upward, in one transaction per bus
+     * (a tree spread over several buses gets one per change of bus along that order).
+     * Calls the handlers with the non-cascade events, returns the number of events.
+     */
+    size_t resolve() {
+        std::vector<size_t> level = { 0 }, next, visited;
+        size_t count = 0;
+
+        while (!level.empty()) {
+            for (size_t i : level) nodes[i].mcp->burstRead(busFor(*nodes[i].mcp), MCP23017::INTFA, nodes[i].regs, 4);
+            if (!runAll()) return count;
+
+            next.clear();
+            for (size_t i : level) {
+                Node &n = nodes[i];
+                uint16_t flags    = (uint16_t(n.regs[1]) << 8) | n.regs[0];
+                uint16_t captured = (uint16_t(n.regs[3]) << 8) | n.regs[2];
+                visited.push_back(i);
+
+                for (auto &c : n.children) {
+                    uint16_t bit = uint16_t(1) << c.pin;
+                    if (flags & bit) next.push_back(c.node);
+                    flags &= ~bit;
+                }
+                flags = n.mcp->queueEdgeRearm(busFor(*n.mcp), flags, captured);
+
+                if (!flags) continue;
+                auto events = intEvents(flags, captured);
+                count += events.size();
+                if (n.handler) n.handler(*n.mcp, events);
+            }
+            if (!runAll()) return count;
+            level.swap(next);
+        }
+
+        I2CBurst clear;
+        MCP23017 *bus = nullptr;
+        for (auto it = visited.rbegin(); it != visited.rend(); ++it) {
+            Node &n = nodes[*it];
+            if (bus && bus->device() != n.mcp->device()) {
+                clear.run(bus->handle());
+                clear.clear();
+            }
+            bus = n.mcp;
+            n.mcp->burstRead(clear, MCP23017::GPIOA, n.gpio, 2);
+        }
+        if (bus) clear.run(bus->handle());
+        return count;
+    }
+
+
+private:
+    struct Child {
+        uint8_t pin;
+        size_t node;
+    };
+
+    struct Node {
+        MCP23017 *mcp;
+        Handler handler;
+        std::vector<Child> children;
+        uint8_t regs[4];
+        uint8_t gpio[2];
+    };
+
+    struct Bus {
+        const MCP23017 *mcp;   // First device on the bus path, its fd runs the transactions
+        I2CBurst burst;
+    };
+
+    static constexpr size_t npos = size_t(-1);
+
+    std::vector<Node> nodes;
+    std::vector<Bus> buses;
+
+    size_t indexOf(const MCP23017 &mcp) const {
+        for (size_t i = 0; i < nodes.size(); i++) if (nodes[i].mcp == &mcp) return i;
+        return npos;
+    }
+
+    I2CBurst &busFor(const MCP23017 &mcp) {
+        for (auto &b : buses) if (b.mcp->device() == mcp.device()) return b.burst;
+        buses.push_back({ &mcp, I2CBurst() });
+        return buses.back().burst;
+    }
+
+    bool runAll() {
+        bool ok = true;
+        for (auto &b : buses) {
+            if (!b.burst.empty()) ok &= b.burst.run(b.mcp->handle());
+            b.burst.clear();
+        }
+        return ok;
+    }
+};
+
+
+
+/* Replaces pinRead() + sleep_for() loops. Requires intOutputMode(..., w_MIRROR = true) when only one
+ * of INTA/INTB is wired to the host line. Without a host line INTF is polled every pollMs.
+ */
+class IntWaiter {
+public:
+
+    explicit IntWaiter(MCP23017 &mcp, HostIntLine *line = nullptr, int pollMs = 10) : mcp(mcp), line(line), pollMs(pollMs) {}
+
+
+    // Returns at once if pin already is at level, otherwise at the interrupt that brings it there.
+    IntWaitResult waitForLevel(uint8_t pin, pin_Value level, std::chrono::milliseconds timeout) {
+        if (pin > 15 || (level != HIGH && level != LOW)) {
+            std::cerr << "Invalid input: waitForLevel(pin 0-15, HIGH/LOW, timeout)" << std::endl;
+            return { false, pin, ERROR, 0 };
+        }
+        uint16_t bit = uint16_t(1) << pin;
+        arm(bit);
+
+        // Reading GPIO also drops interrupts that were pending before this call.
+        uint8_t gpio[2] = {0, 0};
+        I2CBurst burst;
+        mcp.burstRead(burst, MCP23017::GPIOA, gpio, 2);
+        if (!burst.run(mcp.handle())) return { false, pin, ERROR, 0 };
+        if (bool(((uint16_t(gpio[1]) << 8) | gpio[0]) & bit) == (level == HIGH)) return { true, pin, level, now() };
+
+        // A short bounce may be captured in INTCAP while GPIO already shows the level, both count.
+        IntWaitResult r = wait(bit, timeout, [&](uint16_t captured, uint16_t now) {
+            return bool(captured & bit) == (level == HIGH) || bool(now & bit) == (level == HIGH);
+        });
+        if (r.ok) r.level = level;
+        return r;
+    }
+
+
+    // Returns at the first interrupt on a pin of mask, with that pin and its captured level.
+    IntWaitResult waitForAny(uint16_t mask, std::chrono::milliseconds timeout) {
+        if (!mask) {
+            std::cerr << "Invalid input: waitForAny(mask != 0, timeout)" << std::endl;
+            return { false, 0, ERROR, 0 };
+        }
+        arm(mask);
+        return wait(mask, timeout, [](uint16_t, uint16_t) { return true; });
+    }
+
+
+private:
+    MCP23017 &mcp;
+    HostIntLine *line;
+    int pollMs;
+    uint16_t armed = 0;
+
+    static uint64_t now() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+    }
+
+    // Interrupt on change for the pins not enabled by this waiter yet, once.
+    void arm(uint16_t mask) {
+        for (uint8_t pin = 0; pin < 16; pin++) {
+            if (!(mask & ~armed & (1 << pin))) continue;
+            mcp.intTriggerMode(pin, CHANGE);
+            mcp.enableInt(pin);
+        }
+        armed |= mask;
+    }
+
+    /* Sleeps on the host line (or polls INTF), then reads INTF and INTCAP and releases INT with the GPIO read.
+     * accept(captured, gpio) decides if the change ends the wait.
+     */
+    template <class F>
+    IntWaitResult wait(uint16_t mask, std::chrono::milliseconds timeout, F accept) {
+        uint64_t end = now() + uint64_t(timeout.count()) * 1000000ull;
+        I2CBurst burst;
+        uint8_t regs[6];
+
+        while (true) {
+            uint64_t t = now();
+            if (t >= end) return { false, 0, ERROR, 0 };
+            int ms = int((end - t + 999999) / 1000000);
+
+            // The kernel time of an edge consumed now, otherwise (line still held, or polling) the service time.
+            uint64_t stamp = 0;
+            if (line) {
+                bool edge = line->drain() > 0;
+                if (!edge && !line->isActive()) {
+                    if (!line->wait(ms)) continue;
+                    edge = true;
+                }
+                if (edge) stamp = line->lastTimestamp();
+            } else {
+                uint8_t flags[2] = {0, 0};
+                burst.clear();
+                mcp.burstRead(burst, MCP23017::INTFA, flags, 2);
+                if (!burst.run(mcp.handle())) return { false, 0, ERROR, 0 };
+                if (!(((uint16_t(flags[1]) << 8) | flags[0]) & mask)) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(ms < pollMs ? ms : pollMs));
+                    continue;
+                }
+            }
+
+            burst.clear();
+            mcp.burstRead(burst, MCP23017::INTFA, regs, 6);
+            if (!burst.run(mcp.handle())) return { false, 0, ERROR, 0 };
+            uint16_t flags    = (uint16_t(regs[1]) << 8) | regs[0];
+            uint16_t captured = (uint16_t(regs[3]) << 8) | regs[2];
+            uint16_t gpio     = (uint16_t(regs[5]) << 8) | regs[4];
+
+            burst.clear();
+            flags = mcp.queueEdgeRearm(burst, flags, captured) & mask;
+            if (!burst.empty()) burst.run(mcp.handle());
+            if (line) line->drain();   // Edges of what was just serviced must not wake the next wait()
+            if (!flags || !accept(captured, gpio)) continue;
+
+            uint16_t pin = uint16_t(__builtin_ctz(flags));
+            return { true, pin, (captured & (1 << pin)) ? HIGH : LOW, stamp ? stamp : now() };
+        }
+    }
+};
@@ -0,0 +1,216 @@
+/**
+ * @file MCP23017Journal.hpp
+ * @brief Crash-safe journal of the output state of MCP23017 expanders.
+ *
+ * Keeps the last committed OLAT/IODIR/GPPU image of each device in a memory-mapped file.
+ * Every record holds two images, a new image is written to the inactive one and then switched over,
+ * so a crash in the middle of an update still leaves the previous image intact.
+ * After a restart, restore() brings a warm attached device back with one burst write.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "MCP23017.hpp"
+
+struct JournalImage {
+    uint16_t olat;
+    uint16_t iodir;
+    uint16_t gppu;
+};
+
+
+class OutputJournal {
+public:
+    static constexpr uint32_t MAGIC = 0x4D434A31;  // "MCJ1"
+
+    explicit OutputJournal(const std::string &path = "/var/lib/mcp23017.journal", uint32_t maxDevices = 64) {
+        size = sizeof(Header) + maxDevices * sizeof(Record);
+        int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+
+        try {
+           if (fd < 0) throw std::runtime_error("Journal open failed");
+
+           struct stat st;
+           bool fresh = fstat(fd, &st) < 0 || size_t(st.st_size) < sizeof(Header);
+           if (ftruncate(fd, off_t(size)) < 0) throw std::runtime_error("Journal resize failed");
+
+           void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+           if (p == MAP_FAILED) throw std::runtime_error("Journal map failed");
+           head = static_cast<Header *>(p);
+
+           if (fresh || head->magic != MAGIC || head->capacity != maxDevices) {
+               std::memset(p, 0, size);
+               head->magic = MAGIC;
+               head->capacity = maxDevices;
+           }
+        }
+        catch (const std::runtime_error& e) {
+           std::cerr << "Error: " << e.what() << std::endl;
+           head = nullptr;
+        }
+        if (fd >= 0) close(fd);
+    }
+
+    ~OutputJournal() { if (head) munmap(head, size); }
+
+    OutputJournal(const OutputJournal &) = delete;
+    OutputJournal &operator=(const OutputJournal &) = delete;
+
+
+    // Plain memory stores only, no syscall. The kernel keeps the pages if the process dies.
+    void record(const MCP23017 &mcp, const JournalImage &image) {
+        Record *r = find(mcp, true);
+        if (!r) return;
+
+        uint8_t next = r->active ^ 1;
+        r->image[next] = image;
+        r->seq[next] = r->seq[r->active] + 1;
+        r->check[next] = checksum(r->image[next], r->seq[next]);
+
+        std::atomic_thread_fence(std::memory_order_release);
+        r->active = next;
+    }
+
+
+    void recordOutputs(const MCP23017 &mcp, uint16_t olat) {
+        JournalImage image = { olat, 0xFFFF, 0x0000 };
+        lookup(mcp, image);
+        image.olat = olat;
+        record(mcp, image);
+    }
+
+
+    // Reads OLAT, IODIR and GPPU from the chip in one transaction and records them.
+    bool capture(const MCP23017 &mcp) {
+        uint8_t regs[6] = {0, 0, 0, 0, 0, 0};
+        I2CBurst burst;
+        mcp.burstRead(burst, MCP23017::OLATA, &regs[0], 2);
+        mcp.burstRead(burst, MCP23017::IODIRA, &regs[2], 2);
+        mcp.burstRead(burst, MCP23017::GPPUA, &regs[4], 2);
+        if (!burst.run(mcp.handle())) return false;
+
+        record(mcp, { word(&regs[0]), word(&regs[2]), word(&regs[4]) });
+        return true;
+    }
+
+
+    bool lookup(const MCP23017 &mcp, JournalImage &out) const {
+        const Record *r = const_cast<OutputJournal *>(this)->find(mcp, false);
+        if (!r) return false;
+
+        uint8_t a = r->active;
+        if (r->check[a] == checksum(r->image[a], r->seq[a])) out = r->image[a];
+        else if (r->check[a ^ 1] == checksum(r->image[a ^ 1], r->seq[a ^ 1]) && r->seq[a ^ 1]) out = r->image[a ^ 1];
+        else return false;
+        return true;
+    }
+
+
+    /* Writes the journaled image back, OLAT first so outputs come up at their old level,
+     * then IODIR and GPPU. One transaction per bus. Returns the number of devices restored.
+     */
+    size_t restore(const std::vector<MCP23017 *> &devices) {
+        std::map<std::string, std::vector<std::pair<MCP23017 *, JournalImage>>> buses;
+        for (auto *mcp : devices) {
+            JournalImage image;
+            if (lookup(*mcp, image)) buses[mcp->device()].push_back({ mcp, image });
+        }
+
+        size_t restored = 0;
+        I2CBurst burst;
+        std::vector<uint8_t> data;
+        for (auto &bus : buses) {
+            data.resize(bus.second.size() * 6);
+            burst.clear();
+
+            uint8_t *d = data.data();
+            for (auto &entry : bus.second) {
+                setWord(d, entry.second.olat);
+                setWord(d + 2, entry.second.iodir);
+                setWord(d + 4, entry.second.gppu);
+                entry.first->burstWrite(burst, MCP23017::OLATA, d, 2);
+                entry.first->burstWrite(burst, MCP23017::IODIRA, d + 2, 2);
+                entry.first->burstWrite(burst, MCP23017::GPPUA, d + 4, 2);
+                d += 6;
+            }
+            if (burst.run(bus.second.front().first->handle())) restored += bus.second.size();
+        }
+        return restored;
+    }
+
+
+    bool restore(MCP23017 &mcp) { return restore(std::vector<MCP23017 *>{ &mcp }) == 1; }
+
+
+    // Flushes the journal to disk, only needed to survive a power loss.
+    void sync() { if (head) msync(head, size, MS_SYNC); }
+
+
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t capacity;
+    };
+
+    struct Record {
+        char bus[27];
+        uint8_t address;
+        uint8_t used;
+        uint8_t active;
+        uint16_t pad;
+        uint32_t seq[2];
+        uint32_t check[2];
+        JournalImage image[2];
+    };
+
+    Header *head = nullptr;
+    size_t size = 0;
+
+    Record *records() { return reinterpret_cast<Record *>(head + 1); }
+
+    static uint16_t word(const uint8_t *r) { return (uint16_t(r[1]) << 8) | r[0]; }
+
+    static void setWord(uint8_t *r, uint16_t v) {
+        r[0] = uint8_t(v);
+        r[1] = uint8_t(v >> 8);
+    }
+
+    static uint32_t checksum(const JournalImage &i, uint32_t seq) {
+        uint32_t h = 2166136261u ^ seq;
+        for (uint16_t v : { i.olat, i.iodir, i.gppu }) h = (h ^ v) * 16777619u;
+        return h;
+    }
+
+    Record *find(const MCP23017 &mcp, bool create) {
+        if (!head) return nullptr;
+        Record *r = records();
+        for (uint32_t i = 0; i < head->capacity; i++) {
+            if (r[i].used && r[i].address == mcp.address() && std::strncmp(r[i].bus, mcp.device().c_str(), sizeof(r[i].bus) - 1) == 0) return &r[i];
+        }
+        if (!create) return nullptr;
+
+        for (uint32_t i = 0; i < head->capacity; i++) {
+            if (r[i].used) continue;
+            std::memset(&r[i], 0, sizeof(Record));
+            std::strncpy(r[i].bus, mcp.device().c_str(), sizeof(r[i].bus) - 1);
+            r[i].address = mcp.address();
+            r[i].used = 1;
+            return &r[i];
+        }
+        std::cerr << "Error: Journal full" << std::endl;
+        return nullptr;
+    }
+};
@@ -0,0 +1,223 @@
+/**
+ * @file MCP23017Pulse.hpp
+ * @brief Pulse counting and frequency, period and duty measurement on MCP23017 inputs.
+ *
+ * PulseMeter counts the edges of flow sensors, fan tachometers and similar pulse inputs from the
+ * interrupt capture stream or from polled port images, with the kernel edge timestamp or the service time.
+ * Frequency, period and duty cycle are kept incrementally over a sliding time window per pin.
+ * Every edge costs one interrupt service, so a pin is flagged once its rate gets close to what the
+ * bus-limited service rate can follow, and edge pairs lost in between are counted.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#pragma once
+
+#include <ctime>
+
+#include "MCP23017.hpp"
+#include "MCP23017Sched.hpp"
+
+struct PulseReading {
+    uint64_t count = 0;      // Rising edges since add() or reset()
+    uint64_t missed = 0;     // Edge pairs lost between two services (same level seen twice)
+    double frequency = 0.0;  // Hz over the window
+    double period = 0.0;     // Seconds
+    double duty = 0.0;       // High time share 0..1
+    bool overrange = false;  // Edge rate above the service rate, readings are too low
+};
+
+
+/* PulseMeter meter(400000);                          // Bus clock, gives the default service rate
+ * size_t fan = meter.add(mcp, 3, std::chrono::milliseconds(1000));
+ * shared.add(mcp, [&](MCP23017 &m, const std::vector<IntEvent> &ev) { meter.feed(m, ev, line.lastTimestamp()); });
+ * PulseReading r = meter.reading(fan);                // r.frequency * 60 / 2 = rpm of a 2-pulse fan
+ */
+class PulseMeter {
+public:
+
+    // Maximum interrupt services per second, estimated from one INTF/INTCAP/GPIO read (6 data bytes) at clockHz.
+    explicit PulseMeter(uint32_t clockHz = 100000) {
+        I2CBurst probe;
+        uint8_t regs[6];
+        probe.read(0x20, MCP23017::INTFA, regs, 6);
+        serviceHz = 1e9 / double(busTime(probe, clockHz).count());
+    }
+
+
+    // Measured limit of the own service loop, e.g. 1 / worst service latency.
+    void setServiceRate(double hz) { if (hz > 0) serviceHz = hz; }
+
+    double serviceRate() const { return serviceHz; }
+
+
+    // capacity = Rising edges kept per window, more are thinned to the newest ones.
+    size_t add(MCP23017 &mcp, uint8_t pin, std::chrono::milliseconds window = std::chrono::milliseconds(1000), size_t capacity = 1024) {
+        if (pin > 15 || window.count() <= 0 || capacity < 2) {
+            std::cerr << "Invalid input: add(mcp, pin 0-15, window > 0, capacity >= 2)" << std::endl;
+            return SIZE_MAX;
+        }
+        Channel c;
+        c.mcp = &mcp;
+        c.pin = pin;
+        c.window = uint64_t(window.count()) * 1000000ull;
+        c.ring.resize(capacity);
+        channels.push_back(std::move(c));
+        return channels.size() - 1;
+    }
+
+
+    /* One edge with its CLOCK_MONOTONIC timestamp in ns (HostIntLine::lastTimestamp(), 0 = now).
+     * The level is the pin level after the edge.
+     */
+    void feedEdge(MCP23017 &mcp, uint8_t pin, pin_Value level, uint64_t timestamp = 0) {
+        if (!timestamp) timestamp = now();
+        for (auto &c : channels) if (c.mcp == &mcp && c.pin == pin) edge(c, level == HIGH, timestamp);
+    }
+
+
+    /* INTF/INTCAP capture. A GPIO read in the same transaction (gpio >= 0) that differs from INTCAP
+     * shows one more edge after the capture, it is counted with the same timestamp.
+     */
+    void feedCapture(MCP23017 &mcp, uint16_t flags, uint16_t captured, int32_t gpio = -1, uint64_t timestamp = 0) {
+        if (!timestamp) timestamp = now();
+        for (auto &c : channels) {
+            uint16_t bit = uint16_t(1u << c.pin);
+            if (c.mcp != &mcp || !(flags & bit)) continue;
+            edge(c, captured & bit, timestamp);
+            if (gpio >= 0 && bool(gpio & bit) != bool(captured & bit)) edge(c, gpio & bit, timestamp);
+        }
+    }
+
+
+    // Events as delivered by SharedIntLine, SplitIntService or getIntCapture().
+    void feed(MCP23017 &mcp, const std::vector<IntEvent> &events, uint64_t timestamp = 0) {
+        uint16_t flags = 0, captured = 0;
+        for (auto &e : events) {
+            flags |= uint16_t(1u << e.pin);
+            if (e.level) captured |= uint16_t(1u << e.pin);
+        }
+        feedCapture(mcp, flags, captured, -1, timestamp);
+    }
+
+
+    // Polled port image: every pin whose level changed since the last sample had an edge.
+    void feedSample(MCP23017 &mcp, uint16_t gpio, uint64_t timestamp = 0) {
+        if (!timestamp) timestamp = now();
+        for (auto &c : channels) {
+            if (c.mcp != &mcp) continue;
+            bool high = gpio & (1u << c.pin);
+            if (c.level < 0) c.level = high;
+            else if (bool(c.level) != high) edge(c, high, timestamp);
+        }
+    }
+
+
+    // Reading over the window that ends now (or at timestamp), edges older than the window are dropped first.
+    PulseReading reading(size_t id, uint64_t timestamp = 0) {
+        PulseReading r;
+        if (id >= channels.size()) return r;
+        Channel &c = channels[id];
+        expire(c, timestamp ? timestamp : now());
+
+        r.count = c.count;
+        r.missed = c.missed;
+        if (c.size >= 2) {
+            const Entry &first = c.ring[c.head];
+            const Entry &last  = c.ring[(c.head + c.size - 1) % c.ring.size()];
+            double span = double(last.rise - first.rise);
+            if (span > 0) {
+                r.frequency = double(c.size - 1) * 1e9 / span;
+                r.period = 1.0 / r.frequency;
+                r.duty = double(c.sumHigh - first.high) / span;
+                if (r.duty > 1.0) r.duty = 1.0;
+            }
+        }
+        // Two edges per cycle, each needs its own service.
+        r.overrange = r.frequency * 2.0 > serviceHz || c.overrange;
+        return r;
+    }
+
+
+    void reset(size_t id) {
+        if (id >= channels.size()) return;
+        Channel &c = channels[id];
+        c.count = c.missed = 0;
+        c.head = c.size = 0;
+        c.sumHigh = 0;
+        c.overrange = false;
+    }
+
+    size_t size() const { return channels.size(); }
+
+
+private:
+    struct Entry {
+        uint64_t rise;  // Timestamp of a rising edge
+        uint64_t high;  // High time of the cycle that ended with it
+    };
+
+    struct Channel {
+        MCP23017 *mcp = nullptr;
+        uint8_t pin = 0;
+        int8_t level = -1;       // -1 = not seen yet
+        bool overrange = false;  // Missed edges in the current window
+        uint64_t window = 0;
+        uint64_t count = 0;
+        uint64_t missed = 0;
+        uint64_t lastRise = 0;
+        uint64_t lastFall = 0;
+        std::vector<Entry> ring;
+        size_t head = 0;
+        size_t size = 0;
+        uint64_t sumHigh = 0;
+    };
+
+    std::vector<Channel> channels;
+    double serviceHz = 0.0;
+
+    static uint64_t now() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+    }
+
+    void edge(Channel &c, bool high, uint64_t t) {
+        // The same level twice: the opposite edge and this one's partner were lost in between.
+        if (c.level >= 0 && bool(c.level) == high) {
+            c.missed++;
+            c.overrange = true;
+        }
+        c.level = high;
+
+        if (!high) {
+            c.lastFall = t;
+            return;
+        }
+        uint64_t highTime = c.lastRise && c.lastFall > c.lastRise ? c.lastFall - c.lastRise : 0;
+        c.lastRise = t;
+        c.count++;
+
+        expire(c, t);
+        if (c.size == c.ring.size()) pop(c);
+        c.ring[(c.head + c.size) % c.ring.size()] = { t, highTime };
+        c.size++;
+        c.sumHigh += highTime;
+    }
+
+    void expire(Channel &c, uint64_t t) {
+        while (c.size && c.ring[c.head].rise + c.window < t) pop(c);
+        if (!c.size) c.overrange = false;
+    }
+
+    void pop(Channel &c) {
+        c.sumHigh -= c.ring[c.head].high;
+        c.head = (c.head + 1) % c.ring.size();
+        c.size--;
+    }
+};
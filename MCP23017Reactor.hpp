@@ -0,0 +1,286 @@
+/**
+ * @file MCP23017Reactor.hpp
+ * @brief Single-threaded event loop for MCP23017 expanders.
+ *
+ * Reactor multiplexes host INT lines, timers (debounce, PWM, timeouts), periodic port polls and any
+ * other file descriptor in one epoll loop on one thread. Callbacks run to completion in the loop,
+ * so they need no locks as long as they only touch devices driven by this reactor.
+ * Polls with the same period share one timer and read their devices with one transaction per bus.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#include "MCP23017.hpp"
+#include "MCP23017Int.hpp"
+
+struct ReactorStats {
+    uint64_t iterations = 0;
+    uint64_t events = 0;
+    std::chrono::nanoseconds last{0};       // Wake-up to end of the last callback of one iteration
+    std::chrono::nanoseconds max{0};
+    std::chrono::nanoseconds mean{0};
+    std::chrono::nanoseconds timerLate{0};  // Worst delay of a timer callback behind its expiry
+};
+
+
+/* Reactor r;
+ * r.addIntLine(line, [&] { shared.service(); });
+ * r.addTimer(std::chrono::microseconds(500), [&] { mcp.pinWrite(0, (on = !on) ? HIGH : LOW); });   // PWM
+ * r.addPoll(mcp, std::chrono::milliseconds(100), [](uint16_t gpio) { ... });
+ * r.run();
+ */
+class Reactor {
+public:
+    using Callback = std::function<void()>;
+    using PollCallback = std::function<void(uint16_t gpio)>;
+
+    Reactor() {
+        try {
+           ep = epoll_create1(EPOLL_CLOEXEC);
+           if (ep < 0) throw std::runtime_error("epoll create failed");
+        }
+        catch (const std::runtime_error& e) {
+           std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+
+    ~Reactor() {
+        for (auto &s : sources) if (s.owned && s.fd >= 0) close(s.fd);
+        if (ep >= 0) close(ep);
+    }
+
+    Reactor(const Reactor &) = delete;
+    Reactor &operator=(const Reactor &) = delete;
+
+
+    // Any readable fd. The callback has to consume the data. Returns the source id, -1 on error.
+    int addFd(int fd, Callback cb) { return add({ fd, false, FD, std::move(cb), nullptr, 0, 0, SIZE_MAX }); }
+
+
+    // Reads the edge event of the line, then calls cb (lastTimestamp() holds the edge time).
+    int addIntLine(HostIntLine &line, Callback cb) {
+        return add({ line.handle(), false, LINE, std::move(cb), &line, 0, 0, SIZE_MAX });
+    }
+
+
+    /* Calls cb every period, or once after period with repeat = false (debounce, timeouts).
+     * One-shot timers can be started again with restartTimer().
+     */
+    int addTimer(std::chrono::microseconds period, Callback cb, bool repeat = true) {
+        int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (fd < 0) {
+            std::cerr << "Error: timerfd create failed" << std::endl;
+            return -1;
+        }
+        uint64_t ns = uint64_t(period.count()) * 1000ull;
+        int id = add({ fd, true, TIMER, std::move(cb), nullptr, repeat ? ns : 0, 0, SIZE_MAX });
+        if (id >= 0) arm(sources[size_t(id)], ns);
+        return id;
+    }
+
+
+    bool restartTimer(int id, std::chrono::microseconds delay) {
+        if (!valid(id) || sources[size_t(id)].kind != TIMER) return false;
+        arm(sources[size_t(id)], uint64_t(delay.count()) * 1000ull);
+        return true;
+    }
+
+
+    // Reads GPIOA/B of mcp every period. Polls with the same period share a timer and a transaction per bus.
+    int addPoll(MCP23017 &mcp, std::chrono::microseconds period, PollCallback cb) {
+        uint64_t ns = uint64_t(period.count()) * 1000ull;
+        size_t g = 0;
+        while (g < polls.size() && polls[g].period != ns) g++;
+        if (g == polls.size()) {
+            int id = addTimer(period, nullptr);
+            if (id < 0) return -1;
+            polls.push_back({ ns, {}, {}, true });
+            sources[size_t(id)].kind = POLL;
+            sources[size_t(id)].group = g;
+        }
+        polls[g].devs.push_back({ &mcp, std::move(cb), {0, 0} });
+        polls[g].dirty = true;
+        for (size_t i = 0; i < sources.size(); i++) if (sources[i].kind == POLL && sources[i].group == g) return int(i);
+        return -1;
+    }
+
+
+    void remove(int id) {
+        if (!valid(id)) return;
+        Source &s = sources[size_t(id)];
+        epoll_ctl(ep, EPOLL_CTL_DEL, s.fd, nullptr);
+        if (s.owned) close(s.fd);
+        s.fd = -1;
+        s.cb = nullptr;
+    }
+
+
+    /* One epoll_wait (timeoutMs < 0 waits forever) and the callbacks of all ready sources.
+     * Returns the number of sources that fired.
+     */
+    size_t runOnce(int timeoutMs = -1) {
+        epoll_event ev[32];
+        int n = epoll_wait(ep, ev, 32, timeoutMs);
+        if (n <= 0) return 0;
+
+        uint64_t start = now();
+        for (int i = 0; i < n; i++) {
+            size_t id = ev[i].data.u32;
+            if (id < sources.size() && sources[id].fd >= 0) dispatch(sources[id], start);
+        }
+
+        auto t = std::chrono::nanoseconds(now() - start);
+        stat.iterations++;
+        stat.events += uint64_t(n);
+        stat.last = t;
+        if (t > stat.max) stat.max = t;
+        stat.mean += (t - stat.mean) / int64_t(stat.iterations);
+        return size_t(n);
+    }
+
+
+    // Loops until stop() is called, e.g. from a callback.
+    void run() {
+        running = true;
+        while (running) runOnce(-1);
+    }
+
+
+    void stop() { running = false; }
+
+    const ReactorStats &stats() const { return stat; }
+
+
+private:
+    enum : uint8_t { FD, LINE, TIMER, POLL };
+
+    struct Source {
+        int fd;
+        bool owned;        // Timer fds are closed by the reactor
+        uint8_t kind;
+        Callback cb;
+        HostIntLine *line;
+        uint64_t period;   // Timer period in ns, 0 = one-shot
+        uint64_t expiry;   // Next expected expiry, CLOCK_MONOTONIC ns
+        size_t group;      // Poll group
+    };
+
+    struct PollDev {
+        MCP23017 *mcp;
+        PollCallback cb;
+        uint8_t gpio[2];
+    };
+
+    struct PollGroup {
+        uint64_t period;
+        std::deque<PollDev> devs;
+        std::vector<std::pair<MCP23017 *, I2CBurst>> buses;  // First device of each bus, rebuilt on the next tick after a device was added
+        bool dirty;
+    };
+
+    int ep = -1;
+    bool running = false;
+    std::deque<Source> sources;   // Deques: callbacks may add sources while one of them runs
+    std::deque<PollGroup> polls;
+    ReactorStats stat;
+
+    static uint64_t now() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+    }
+
+    bool valid(int id) const { return id >= 0 && size_t(id) < sources.size() && sources[size_t(id)].fd >= 0; }
+
+    int add(Source s) {
+        if (ep < 0 || s.fd < 0) {
+            std::cerr << "Invalid input: Reactor source without fd" << std::endl;
+            return -1;
+        }
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = 0;
+        ev.data.u32 = uint32_t(sources.size());
+        if (epoll_ctl(ep, EPOLL_CTL_ADD, s.fd, &ev) < 0) {
+            std::cerr << "Error: epoll add failed" << std::endl;
+            if (s.owned) close(s.fd);
+            return -1;
+        }
+        sources.push_back(std::move(s));
+        return int(sources.size() - 1);
+    }
+
+    void arm(Source &s, uint64_t ns) {
+        if (!ns) ns = 1;
+        itimerspec its{};
+        its.it_value.tv_sec = time_t(ns / 1000000000ull);
+        its.it_value.tv_nsec = long(ns % 1000000000ull);
+        its.it_interval.tv_sec = time_t(s.period / 1000000000ull);
+        its.it_interval.tv_nsec = long(s.period % 1000000000ull);
+        s.expiry = now() + ns;
+        timerfd_settime(s.fd, 0, &its, nullptr);
+    }
+
+    void dispatch(Source &s, uint64_t woke) {
+        switch (s.kind) {
+            case FD:
+                if (s.cb) s.cb();
+                break;
+
+            case LINE:
+                // One event per wake-up, the line fd blocks once its queue is empty.
+                if (!s.line->readEvent()) break;
+                if (s.cb) s.cb();
+                break;
+
+            case TIMER:
+            case POLL: {
+                uint64_t expirations = 0;
+                if (read(s.fd, &expirations, sizeof(expirations)) != sizeof(expirations)) break;
+                if (woke > s.expiry) {
+                    auto late = std::chrono::nanoseconds(woke - s.expiry);
+                    if (late > stat.timerLate) stat.timerLate = late;
+                }
+                s.expiry += s.period * expirations;
+                if (s.kind == POLL) poll(polls[s.group]);
+                else if (s.cb) s.cb();
+                break;
+            }
+        }
+    }
+
+    // GPIO of all devices in the group, one transaction per bus, then the callbacks.
+    void poll(PollGroup &g) {
+        if (g.dirty) {
+            g.buses.clear();
+            for (auto &d : g.devs) {
+                size_t b = 0;
+                while (b < g.buses.size() && g.buses[b].first->device() != d.mcp->device()) b++;
+                if (b == g.buses.size()) g.buses.push_back({ d.mcp, I2CBurst() });
+                d.mcp->burstRead(g.buses[b].second, MCP23017::GPIOA, d.gpio, 2);
+            }
+            g.dirty = false;
+        }
+        bool ok = true;
+        for (auto &b : g.buses) ok &= b.second.run(b.first->handle());
+        if (!ok) return;
+        for (size_t i = 0, n = g.devs.size(); i < n; i++) {
+            PollDev &d = g.devs[i];
+            if (d.cb) d.cb((uint16_t(d.gpio[1]) << 8) | d.gpio[0]);
+        }
+    }
+};
@@ -0,0 +1,300 @@
+/**
+ * @file MCP23017Rt.hpp
+ * @brief Real-time interrupt service for MCP23017 expanders.
+ *
+ * RtProfile locks the process memory and puts threads on SCHED_FIFO and a fixed CPU.
+ * RtIntService serves one host INT line from such a thread. All transaction and event buffers are
+ * allocated before start(), the service path does no heap allocation and no iostream output
+ * (only a failed transaction still reports its error).
+ * Events go through a lock-free ring to the application, the latency from the kernel edge timestamp
+ * to the captured registers is measured for every interrupt.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <thread>
+
+#include "MCP23017.hpp"
+#include "MCP23017Int.hpp"
+
+struct RtEvent {
+    uint16_t dev;       // Index in the order of add()
+    uint16_t flags;     // INTF
+    uint16_t captured;  // INTCAP
+    uint64_t edgeNs;    // Kernel timestamp of the host line edge, CLOCK_MONOTONIC, 0 = no edge of its own
+    uint64_t doneNs;    // Registers captured
+};
+
+struct RtLatency {
+    uint64_t samples = 0;
+    uint64_t errors = 0;      // Failed transactions
+    uint64_t overflows = 0;   // Events dropped because the ring was full
+    std::chrono::nanoseconds worst{0};
+    std::chrono::nanoseconds mean{0};
+    std::chrono::nanoseconds wakeWorst{0};  // selfTest(): worst timer wake-up delay of an RT thread
+};
+
+
+class RtProfile {
+public:
+
+    // Locks current and future pages and touches stackBytes of stack, so the service path never page faults.
+    static bool lockMemory(size_t stackBytes = 256 * 1024) {
+        try {
+           if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) throw std::runtime_error("mlockall failed, needs CAP_IPC_LOCK or a higher RLIMIT_MEMLOCK");
+        }
+        catch (const std::runtime_error& e) {
+           std::cerr << "Error: " << e.what() << std::endl;
+           return false;
+        }
+        prefault(stackBytes);
+        return true;
+    }
+
+
+    // SCHED_FIFO priority 1-99 and, with cpu >= 0, affinity to that CPU (ideally one given to isolcpus=).
+    static bool setThread(pthread_t thread, int priority, int cpu = -1) {
+        try {
+           sched_param sp{};
+           sp.sched_priority = priority;
+           if (pthread_setschedparam(thread, SCHED_FIFO, &sp) != 0) throw std::runtime_error("SCHED_FIFO not permitted");
+           if (cpu >= 0) {
+               cpu_set_t set;
+               CPU_ZERO(&set);
+               CPU_SET(cpu, &set);
+               if (pthread_setaffinity_np(thread, sizeof(set), &set) != 0) throw std::runtime_error("CPU affinity failed");
+           }
+        }
+        catch (const std::runtime_error& e) {
+           std::cerr << "Error: " << e.what() << std::endl;
+           return false;
+        }
+        return true;
+    }
+
+
+    static uint64_t now() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+    }
+
+
+private:
+    static void prefault(size_t bytes) {
+        volatile uint8_t stack[4096];
+        for (size_t i = 0; i < sizeof(stack); i += 64) stack[i] = 0;
+        if (bytes > sizeof(stack)) prefault(bytes - sizeof(stack));
+    }
+};
+
+
+/* RtIntService rt(line, 1024);
+ * rt.add(mcp1); rt.add(mcp2);     // Open-drain INT outputs on one host line, same bus
+ * rt.start(80, 3);                // SCHED_FIFO 80 on CPU 3
+ * RtEvent e; while (rt.pop(e)) ...  // From any one non-RT thread
+ */
+class RtIntService {
+public:
+
+    // capacity = Event ring size, rounded up to a power of two.
+    explicit RtIntService(HostIntLine &line, size_t capacity = 1024) : line(line) {
+        size_t n = 1;
+        while (n < capacity) n <<= 1;
+        ring.resize(n);
+        ringMask = n - 1;
+    }
+
+    ~RtIntService() { stop(); }
+
+    RtIntService(const RtIntService &) = delete;
+    RtIntService &operator=(const RtIntService &) = delete;
+
+
+    void add(MCP23017 &mcp) {
+        if (worker.joinable()) {
+            std::cerr << "Invalid input: add() after start()" << std::endl;
+            return;
+        }
+        if (!chips.empty() && chips.front().mcp->device() != mcp.device()) {
+            std::cerr << "Invalid input: all chips on a shared INT line must be on the same bus" << std::endl;
+            return;
+        }
+        chips.push_back({ &mcp, {0, 0, 0, 0} });
+    }
+
+
+    /* Builds all bursts, locks memory and starts the service thread.
+     * priority 0 keeps the normal scheduler, cpu < 0 keeps all CPUs.
+     * Returns false without a running thread if memory can not be locked or the thread not be scheduled.
+     */
+    bool start(int priority = 80, int cpu = -1, bool lockMemory = true) {
+        if (worker.joinable() || chips.empty() || line.handle() < 0) return false;
+
+        read.clear();
+        for (auto &c : chips) c.mcp->burstRead(read, MCP23017::INTFA, c.regs, 4);
+        read.reserve(read.size(), read.size());
+        // Worst rearm per chip without sequential operation: two DEFVAL writes and two GPIO reads, 6 messages.
+        rearm.reserve(chips.size() * 6, chips.size() * 8);
+
+        if (lockMemory && !RtProfile::lockMemory()) return false;
+        running = true;
+        worker = std::thread(&RtIntService::loop, this);
+        if (priority > 0 && !RtProfile::setThread(worker.native_handle(), priority, cpu)) {
+            stop();
+            return false;
+        }
+        prio = priority;
+        cpuId = cpu;
+        return true;
+    }
+
+
+    void stop() {
+        running = false;
+        if (worker.joinable()) worker.join();
+    }
+
+
+    // Takes the oldest event. Single consumer.
+    bool pop(RtEvent &out) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        out = ring[t & ringMask];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+
+    RtLatency latency() const {
+        RtLatency l;
+        l.samples = samples.load();
+        l.errors = errors.load();
+        l.overflows = overflows.load();
+        l.worst = std::chrono::nanoseconds(worstNs.load());
+        l.mean = std::chrono::nanoseconds(l.samples ? sumNs.load() / l.samples : 0);
+        return l;
+    }
+
+
+    void resetLatency() {
+        samples = 0;
+        sumNs = 0;
+        worstNs = 0;
+    }
+
+
+    /* Runs for duration and reports the worst service latency seen in that time.
+     * A second thread with the same priority and CPU wakes every period on an absolute timer
+     * and records how late it woke, the scheduling part of the latency without any interrupt traffic.
+     */
+    RtLatency selfTest(std::chrono::milliseconds duration, std::chrono::microseconds period = std::chrono::microseconds(1000)) {
+        resetLatency();
+        uint64_t wakeWorst = 0;
+
+        std::thread probe([&] {
+            uint64_t step = uint64_t(period.count()) * 1000ull;
+            uint64_t end = RtProfile::now() + uint64_t(duration.count()) * 1000000ull;
+            uint64_t next = RtProfile::now() + step;
+            while (next < end) {
+                timespec ts = { time_t(next / 1000000000ull), long(next % 1000000000ull) };
+                clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+                uint64_t late = RtProfile::now() - next;
+                if (late > wakeWorst) wakeWorst = late;
+                next += step;
+            }
+        });
+        if (prio > 0) RtProfile::setThread(probe.native_handle(), prio, cpuId);
+        probe.join();
+
+        RtLatency l = latency();
+        l.wakeWorst = std::chrono::nanoseconds(wakeWorst);
+        return l;
+    }
+
+
+private:
+    struct Chip {
+        MCP23017 *mcp;
+        uint8_t regs[4];
+    };
+
+    HostIntLine &line;
+    std::vector<Chip> chips;
+    I2CBurst read;
+    I2CBurst rearm;
+    std::vector<RtEvent> ring;
+    size_t ringMask = 0;
+    std::atomic<size_t> head{0}, tail{0};
+    std::atomic<uint64_t> samples{0}, sumNs{0}, worstNs{0}, errors{0}, overflows{0};
+    std::atomic<bool> running{false};
+    std::thread worker;
+    int prio = 0;
+    int cpuId = -1;
+
+    // Service path: prebuilt read burst, rearm burst within reserved capacity, ring writes. No allocation.
+    void loop() {
+        pollfd p = { line.handle(), POLLIN, 0 };
+        while (running) {
+            if (!line.isActive() && poll(&p, 1, 100) <= 0) continue;
+
+            for (int round = 0; round < 8; round++) {
+                // Consume the edges queued so far, this read services them. The oldest one gives the latency,
+                // a round without a queued edge (line held by a later flag) records none.
+                uint64_t edge = 0;
+                while (poll(&p, 1, 0) > 0 && line.readEvent()) if (!edge) edge = line.lastTimestamp();
+
+                if (!read.run(chips.front().mcp->handle())) {
+                    errors++;
+                    break;
+                }
+                uint64_t done = RtProfile::now();
+                record(edge && done > edge ? done - edge : 0);
+
+                rearm.clear();
+                for (uint16_t i = 0; i < chips.size(); i++) {
+                    Chip &c = chips[i];
+                    uint16_t flags    = (uint16_t(c.regs[1]) << 8) | c.regs[0];
+                    uint16_t captured = (uint16_t(c.regs[3]) << 8) | c.regs[2];
+                    if (!flags) continue;
+                    flags = c.mcp->queueEdgeRearm(rearm, flags, captured);
+                    if (flags) push({ i, flags, captured, edge, done });
+                }
+                if (!rearm.empty() && !rearm.run(chips.front().mcp->handle())) errors++;
+
+                if (!line.isActive()) break;
+            }
+        }
+    }
+
+    void record(uint64_t ns) {
+        if (!ns) return;
+        samples.fetch_add(1, std::memory_order_relaxed);
+        sumNs.fetch_add(ns, std::memory_order_relaxed);
+        if (ns > worstNs.load(std::memory_order_relaxed)) worstNs.store(ns, std::memory_order_relaxed);
+    }
+
+    void push(const RtEvent &e) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) > ringMask) {
+            overflows++;
+            return;
+        }
+        ring[h & ringMask] = e;
+        head.store(h + 1, std::memory_order_release);
+    }
+};
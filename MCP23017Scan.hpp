@@ -0,0 +1,292 @@
+/**
+ * @file MCP23017Scan.hpp
+ * @brief Cyclic soft-PLC scan engine for MCP23017 expanders.
+ *
+ * Each cycle reads the inputs of all devices with one transaction per bus, evaluates a rule program
+ * of word-wide bitwise operations over the 16 bit port images, and writes back only the output words that changed.
+ * Cycle time and jitter against a fixed cycle period are reported.
+ * The port images of all devices live in FleetBits arrays, so a FleetProgram evaluates one rule for the whole fleet with SIMD.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+
+#include "MCP23017.hpp"
+#include "MCP23017Fleet.hpp"
+
+enum scan_Op : uint8_t { SCAN_LOAD, SCAN_AND, SCAN_OR, SCAN_XOR, SCAN_ANDN, SCAN_NOT, SCAN_SHL, SCAN_SHR, SCAN_STORE };
+enum scan_Src : uint8_t { SRC_INPUT, SRC_OUTPUT, SRC_CONST };
+
+struct ScanOp {
+    scan_Op op;
+    scan_Src src;
+    uint16_t dev;    // Device id, or shift count
+    uint16_t value;  // Constant, or STORE mask
+};
+
+struct ScanStats {
+    uint64_t cycles = 0;
+    uint64_t overruns = 0;      // Cycles that took longer than the period
+    uint64_t writes = 0;        // Output words written
+    uint64_t readErrors = 0;    // Cycles skipped because an input read failed
+    uint64_t writeErrors = 0;   // Failed output transactions
+    std::chrono::nanoseconds last{0}, min{0}, max{0}, mean{0};
+    std::chrono::nanoseconds jitter{0};  // Worst deviation of a cycle start from its schedule
+};
+
+
+/* Accumulator program over 16 bit words, e.g. "outputs of device 1 = inputs of device 0 AND NOT inputs of device 2":
+ *   ScanProgram().load(SRC_INPUT, 0).andNot(SRC_INPUT, 2).store(1)
+ */
+class ScanProgram {
+public:
+
+    ScanProgram &load(scan_Src src, uint16_t devOrConst)   { return add(SCAN_LOAD, src, devOrConst); }
+    ScanProgram &andWith(scan_Src src, uint16_t devOrConst) { return add(SCAN_AND, src, devOrConst); }
+    ScanProgram &orWith(scan_Src src, uint16_t devOrConst)  { return add(SCAN_OR, src, devOrConst); }
+    ScanProgram &xorWith(scan_Src src, uint16_t devOrConst) { return add(SCAN_XOR, src, devOrConst); }
+    ScanProgram &andNot(scan_Src src, uint16_t devOrConst)  { return add(SCAN_ANDN, src, devOrConst); }
+
+    ScanProgram &invert()          { ops.push_back({ SCAN_NOT, SRC_CONST, 0, 0 }); return *this; }
+    ScanProgram &shiftLeft(int n)  { ops.push_back({ SCAN_SHL, SRC_CONST, uint16_t(n & 15), 0 }); return *this; }
+    ScanProgram &shiftRight(int n) { ops.push_back({ SCAN_SHR, SRC_CONST, uint16_t(n & 15), 0 }); return *this; }
+
+    // Output image of dev = accumulator under mask, other output bits keep their value.
+    ScanProgram &store(uint16_t dev, uint16_t mask = 0xFFFF) {
+        ops.push_back({ SCAN_STORE, SRC_OUTPUT, dev, mask });
+        return *this;
+    }
+
+    const std::vector<ScanOp> &code() const { return ops; }
+
+
+private:
+    std::vector<ScanOp> ops;
+
+    ScanProgram &add(scan_Op op, scan_Src src, uint16_t v) {
+        if (src == SRC_CONST) ops.push_back({ op, src, 0, v });
+        else ops.push_back({ op, src, v, 0 });
+        return *this;
+    }
+};
+
+
+class ScanEngine {
+public:
+
+    // Returns the device id used in ScanProgram.
+    uint16_t addDevice(MCP23017 &mcp) {
+        Bus *bus = nullptr;
+        for (auto &b : buses) if (devs[b.devs.front()].mcp->device() == mcp.device()) bus = &b;
+        if (!bus) {
+            buses.push_back({ mcp.handle(), {}, I2CBurst(), I2CBurst() });
+            bus = &buses.back();
+        }
+        bus->devs.push_back(uint16_t(devs.size()));
+        devs.push_back({ &mcp, {0, 0}, {0, 0}, {0, 0} });
+        inputs.resize(devs.size());
+        outputs.resize(devs.size());
+        written.resize(devs.size());
+        prepared = false;
+        return uint16_t(devs.size() - 1);
+    }
+
+
+    // Checks device ids and prepares the bursts. The program is copied, later changes to it need a new load().
+    bool load(const ScanProgram &program) {
+        for (auto &op : program.code()) {
+            if (op.src != SRC_CONST && op.op != SCAN_NOT && op.op != SCAN_SHL && op.op != SCAN_SHR && op.dev >= devs.size()) {
+                std::cerr << "Invalid input: ScanProgram uses unknown device " << op.dev << std::endl;
+                return false;
+            }
+        }
+        code = program.code();
+        prepared = false;
+        return true;
+    }
+
+
+    // Fleet-wide rule, evaluated after the word program of load(ScanProgram).
+    bool load(const FleetProgram &program) {
+        if (!program.valid(devs.size())) {
+            std::cerr << "Invalid input: FleetProgram images must match the number of devices" << std::endl;
+            return false;
+        }
+        fleet = program;
+        hasFleet = true;
+        return true;
+    }
+
+
+    void setPeriod(std::chrono::microseconds p) { period = p; }
+
+    const ScanStats &stats() const { return stat; }
+
+    uint16_t input(uint16_t dev) const { return inputs[dev]; }
+
+    uint16_t output(uint16_t dev) const { return outputs[dev]; }
+
+
+    /* One scan: burst read, evaluate, burst write of changed words. Returns false on a bus error.
+     * The program may combine inputs of all buses, so a failed read skips evaluation and writes
+     * of the whole cycle and the previous input image stays.
+     */
+    bool scan() {
+        if (!prepared && !prepare()) return false;
+        auto start = std::chrono::steady_clock::now();
+        bool ok = true;
+
+        for (auto &b : buses) ok &= b.read.run(b.fd);
+        if (!ok) {
+            stat.readErrors++;
+            record(std::chrono::steady_clock::now() - start);
+            return false;
+        }
+        for (size_t i = 0; i < devs.size(); i++) inputs[i] = word(devs[i].in);
+
+        evaluate();
+
+        for (auto &b : buses) {
+            b.write.clear();
+            for (uint16_t i : b.devs) {
+                Dev &d = devs[i];
+                uint16_t diff = outputs[i] ^ written[i];
+                if (!diff) continue;
+
+                d.out[0] = uint8_t(outputs[i]);
+                d.out[1] = uint8_t(outputs[i] >> 8);
+                if ((diff & 0x00FF) && (diff & 0xFF00)) d.mcp->burstWrite(b.write, MCP23017::OLATA, d.out, 2);
+                else if (diff & 0x00FF) d.mcp->burstWrite(b.write, MCP23017::OLATA, &d.out[0], 1);
+                else d.mcp->burstWrite(b.write, MCP23017::OLATB, &d.out[1], 1);
+                stat.writes++;
+            }
+            if (b.write.empty()) continue;
+            if (b.write.run(b.fd)) {
+                for (uint16_t i : b.devs) written[i] = outputs[i];
+            } else {
+                stat.writeErrors++;
+                ok = false;
+            }
+        }
+
+        record(std::chrono::steady_clock::now() - start);
+        return ok;
+    }
+
+
+    /* Scans with a fixed period on absolute CLOCK_MONOTONIC deadlines until running is false
+     * or cycles scans are done (0 = endless).
+     */
+    void run(std::atomic<bool> &running, uint64_t cycles = 0) {
+        timespec next;
+        clock_gettime(CLOCK_MONOTONIC, &next);
+
+        for (uint64_t n = 0; running && (cycles == 0 || n < cycles); n++) {
+            timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            auto late = std::chrono::nanoseconds((now.tv_sec - next.tv_sec) * 1000000000ll + (now.tv_nsec - next.tv_nsec));
+            if (late < std::chrono::nanoseconds(0)) late = -late;
+            if (n > 0 && late > stat.jitter) stat.jitter = late;
+
+            scan();
+
+            next.tv_nsec += long(std::chrono::duration_cast<std::chrono::nanoseconds>(period).count());
+            while (next.tv_nsec >= 1000000000l) {
+                next.tv_nsec -= 1000000000l;
+                next.tv_sec++;
+            }
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            if (now.tv_sec > next.tv_sec || (now.tv_sec == next.tv_sec && now.tv_nsec > next.tv_nsec)) {
+                stat.overruns++;
+                next = now;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+        }
+    }
+
+
+private:
+    struct Dev {
+        MCP23017 *mcp;
+        uint8_t in[2];
+        uint8_t out[2];
+        uint8_t olat[2];
+    };
+
+    struct Bus {
+        int fd;                      // Of the first device on the bus path
+        std::vector<uint16_t> devs;
+        I2CBurst read;
+        I2CBurst write;
+    };
+
+    std::vector<Dev> devs;
+    std::vector<Bus> buses;
+    FleetBits inputs, outputs, written;
+    std::vector<ScanOp> code;
+    FleetProgram fleet;
+    bool hasFleet = false;
+    std::chrono::microseconds period{10000};
+    ScanStats stat;
+    bool prepared = false;
+
+    static uint16_t word(const uint8_t *r) { return (uint16_t(r[1]) << 8) | r[0]; }
+
+    // Current latches become the output image, then the input read burst is built once.
+    bool prepare() {
+        if (hasFleet && !fleet.valid(devs.size())) {
+            std::cerr << "Invalid input: FleetProgram images must match the number of devices" << std::endl;
+            hasFleet = false;
+        }
+        for (auto &b : buses) {
+            I2CBurst burst;
+            for (uint16_t i : b.devs) devs[i].mcp->burstRead(burst, MCP23017::OLATA, devs[i].olat, 2);
+            if (!burst.run(b.fd)) return false;
+
+            b.read.clear();
+            for (uint16_t i : b.devs) {
+                outputs[i] = written[i] = word(devs[i].olat);
+                devs[i].mcp->burstRead(b.read, MCP23017::GPIOA, devs[i].in, 2);
+            }
+        }
+        prepared = true;
+        return true;
+    }
+
+    void evaluate() {
+        uint16_t acc = 0;
+        for (const ScanOp &op : code) {
+            uint16_t v = op.src == SRC_INPUT ? inputs[op.dev] : op.src == SRC_OUTPUT ? outputs[op.dev] : op.value;
+            switch (op.op) {
+                case SCAN_LOAD:  acc = v; break;
+                case SCAN_AND:   acc &= v; break;
+                case SCAN_OR:    acc |= v; break;
+                case SCAN_XOR:   acc ^= v; break;
+                case SCAN_ANDN:  acc &= ~v; break;
+                case SCAN_NOT:   acc = ~acc; break;
+                case SCAN_SHL:   acc = uint16_t(acc << op.dev); break;
+                case SCAN_SHR:   acc = uint16_t(acc >> op.dev); break;
+                case SCAN_STORE: outputs[op.dev] = (outputs[op.dev] & ~op.value) | (acc & op.value); break;
+            }
+        }
+        if (hasFleet) fleet.evaluate(inputs, outputs);
+    }
+
+    void record(std::chrono::nanoseconds t) {
+        stat.cycles++;
+        stat.last = t;
+        if (stat.cycles == 1 || t < stat.min) stat.min = t;
+        if (t > stat.max) stat.max = t;
+        stat.mean += (t - stat.mean) / int64_t(stat.cycles);
+    }
+};
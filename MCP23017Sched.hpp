@@ -0,0 +1,631 @@
+/**
+ * @file MCP23017Sched.hpp
+ * @brief Bus schedulers for MCP23017 expanders.
+ *
+ * PollScheduler samples inputs at different rates. Every registered pin set has its own period,
+ * the scheduler merges them into one timeline over the hyperperiod, where each tick reads every
+ * due device once. The resulting bus load is known before polling starts.
+ *
+ * BusScheduler runs the transactions of one bus by priority class. Long bursts are sent in slices
+ * at message boundaries, so urgent work waits at most one slice. Waiting low classes are aged up.
+ *
+ * EdfScheduler runs the transactions of one bus earliest deadline first. Periodic tasks are admitted
+ * only if their estimated bus time fits, deadline misses are counted per task.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+#include "MCP23017.hpp"
+
+// Time a burst occupies the bus: 9 clocks per byte (data + ACK), about 2 for START/STOP per message.
+inline std::chrono::nanoseconds busTime(size_t wireBytes, size_t messages, uint32_t clockHz) {
+    uint64_t bits = uint64_t(wireBytes) * 9 + uint64_t(messages) * 2;
+    return std::chrono::nanoseconds(bits * 1000000000ull / clockHz);
+}
+
+
+inline std::chrono::nanoseconds busTime(const I2CBurst &burst, uint32_t clockHz) {
+    return busTime(burst.wireBytes(), burst.size(), clockHz);
+}
+
+
+enum bus_Class : uint8_t { BUS_URGENT, BUS_INTERRUPT, BUS_POLLING, BUS_DIAGNOSTIC };
+
+struct BusClassStats {
+    uint64_t jobs = 0;
+    uint64_t slices = 0;
+    uint64_t aged = 0;                       // Slices served because the job waited past the aging limit
+    std::chrono::nanoseconds meanDelay{0};   // Submit to first slice
+    std::chrono::nanoseconds maxDelay{0};
+};
+
+
+struct EdfTaskStats {
+    uint64_t runs = 0;
+    uint64_t overruns = 0;                      // Releases skipped because the scheduler fell a whole period behind
+    uint64_t misses = 0;                        // Jobs that finished after their deadline
+    std::chrono::nanoseconds cost{0};           // Estimated bus time per job
+    std::chrono::nanoseconds worstLateness{0};  // Finish minus deadline, worst case (negative = slack)
+};
+
+
+struct PollReport {
+    std::chrono::microseconds tick{0};         // Greatest common divisor of all periods
+    std::chrono::microseconds hyperperiod{0};  // Least common multiple of all periods
+    size_t ticks = 0;                          // Ticks per hyperperiod
+    size_t transactions = 0;                   // Bus transactions per hyperperiod
+    std::vector<double> busLoad;               // Share of bus time per bus, 1.0 = saturated
+    bool ok = false;
+};
+
+
+/* PollScheduler poll(400000);   // Bus clock in Hz
+ * poll.add(mcp1, 0x0003, std::chrono::microseconds(1000), onEncoder);    // 1 kHz
+ * poll.add(mcp2, 0x00F0, std::chrono::microseconds(100000), onDoors);    // 10 Hz
+ * PollReport r = poll.plan();   // Check r.busLoad, then poll.run(running)
+ */
+class PollScheduler {
+public:
+    using Handler = std::function<void(uint16_t value)>;  // GPIO bits under the registered mask
+
+    static constexpr size_t MAX_TICKS = 100000;
+
+    explicit PollScheduler(uint32_t clockHz = 100000) : clock(clockHz) {}
+
+
+    // Registers a pin set (mask of pins 0-15) with its sampling period. Returns the entry id.
+    size_t add(MCP23017 &mcp, uint16_t mask, std::chrono::microseconds period, Handler handler) {
+        if (!mask || period.count() <= 0) {
+            std::cerr << "Invalid input: add(mcp, mask != 0, period > 0, handler)" << std::endl;
+            return SIZE_MAX;
+        }
+        uint16_t d = 0;
+        while (d < devs.size() && devs[d].mcp != &mcp) d++;
+        if (d == devs.size()) devs.push_back({ &mcp, 0, {0, 0} });
+
+        entries.push_back({ d, mask, period, 0, handler });
+        planned = false;
+        return entries.size() - 1;
+    }
+
+
+    // Builds the merged timeline. Call before poll() to check the bus load.
+    const PollReport &plan() {
+        report = PollReport();
+        slots.clear();
+        timeline.clear();
+        buses.clear();
+        pos = 0;
+        planned = true;
+        if (entries.empty()) return report;
+
+        int64_t tick = entries[0].period.count(), hyper = tick;
+        for (auto &e : entries) {
+            tick = std::gcd(tick, int64_t(e.period.count()));
+            hyper = std::lcm(hyper, int64_t(e.period.count()));
+            if (hyper / tick > int64_t(MAX_TICKS)) {
+                std::cerr << "Invalid input: Poll periods give more than " << MAX_TICKS << " ticks per hyperperiod" << std::endl;
+                return report;
+            }
+        }
+        for (auto &e : entries) e.every = uint32_t(e.period.count() / tick);
+        for (auto &d : devs) {
+            d.bus = 0;
+            while (d.bus < buses.size() && buses[d.bus]->device() != d.mcp->device()) d.bus++;
+            if (d.bus == buses.size()) buses.push_back(d.mcp);
+        }
+
+        // Ticks with the same due entries share one slot and its prebuilt bursts.
+        std::map<std::vector<uint16_t>, size_t> known;
+        std::vector<size_t> uses;
+        size_t count = size_t(hyper / tick);
+        for (size_t t = 0; t < count; t++) {
+            std::vector<uint16_t> due;
+            for (size_t i = 0; i < entries.size(); i++) if (t % entries[i].every == 0) due.push_back(uint16_t(i));
+
+            auto it = known.find(due);
+            if (it == known.end()) {
+                it = known.emplace(due, slots.size()).first;
+                slots.push_back(build(due));
+                uses.push_back(0);
+            }
+            timeline.push_back(it->second);
+            uses[it->second]++;
+        }
+
+        report.tick = std::chrono::microseconds(tick);
+        report.hyperperiod = std::chrono::microseconds(hyper);
+        report.ticks = count;
+        report.busLoad.assign(buses.size(), 0.0);
+        for (size_t s = 0; s < slots.size(); s++) {
+            for (size_t b = 0; b < buses.size(); b++) {
+                if (slots[s].bursts[b].empty()) continue;
+                report.transactions += uses[s];
+                report.busLoad[b] += double(busTime(slots[s].bursts[b], clock).count()) * double(uses[s]);
+            }
+        }
+        report.ok = true;
+        for (auto &load : report.busLoad) {
+            load /= double(hyper) * 1000.0;
+            if (load > 1.0) report.ok = false;
+        }
+        return report;
+    }
+
+
+    const PollReport &lastPlan() const { return report; }
+
+    uint64_t overruns() const { return overrun; }
+
+
+    // One tick: one transaction per bus for the devices due now, then the handlers. Returns false on a bus error.
+    bool poll() {
+        if (!planned) plan();
+        if (timeline.empty()) return false;
+
+        Slot &slot = slots[timeline[pos]];
+        pos = (pos + 1) % timeline.size();
+
+        bool ok = true;
+        for (size_t b = 0; b < buses.size(); b++) {
+            busOk[b] = slot.bursts[b].empty() || slot.bursts[b].run(buses[b]->handle());
+            ok &= busOk[b];
+        }
+        for (uint16_t i : slot.due) {
+            Entry &e = entries[i];
+            Dev &d = devs[e.dev];
+            if (busOk[d.bus] && e.handler) e.handler(uint16_t((uint16_t(d.gpio[1]) << 8) | d.gpio[0]) & e.mask);
+        }
+        return ok;
+    }
+
+
+    // Polls every tick on absolute CLOCK_MONOTONIC deadlines until running is false or ticks polls are done (0 = endless).
+    void run(std::atomic<bool> &running, uint64_t ticks = 0) {
+        if (!planned) plan();
+        if (!report.ok) return;
+
+        long step = long(report.tick.count()) * 1000l;
+        timespec next;
+        clock_gettime(CLOCK_MONOTONIC, &next);
+
+        for (uint64_t n = 0; running && (ticks == 0 || n < ticks); n++) {
+            poll();
+
+            next.tv_nsec += step;
+            while (next.tv_nsec >= 1000000000l) {
+                next.tv_nsec -= 1000000000l;
+                next.tv_sec++;
+            }
+            timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            if (now.tv_sec > next.tv_sec || (now.tv_sec == next.tv_sec && now.tv_nsec > next.tv_nsec)) {
+                overrun++;
+                next = now;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+        }
+    }
+
+
+private:
+    struct Entry {
+        uint16_t dev;
+        uint16_t mask;
+        std::chrono::microseconds period;
+        uint32_t every;  // Period in ticks
+        Handler handler;
+    };
+
+    struct Dev {
+        MCP23017 *mcp;
+        uint16_t bus;
+        uint8_t gpio[2];
+    };
+
+    struct Slot {
+        std::vector<uint16_t> due;
+        std::vector<I2CBurst> bursts;  // One per bus, empty if nothing is due there
+    };
+
+    uint32_t clock;
+    std::vector<Entry> entries;
+    std::vector<Dev> devs;
+    std::vector<MCP23017 *> buses;  // First device on each bus path
+    std::vector<Slot> slots;
+    std::vector<size_t> timeline;
+    std::vector<uint8_t> busOk;
+    PollReport report;
+    size_t pos = 0;
+    uint64_t overrun = 0;
+    bool planned = false;
+
+    // One GPIO read per due device covering all due pins: port A, port B or both.
+    Slot build(const std::vector<uint16_t> &due) {
+        Slot slot{ due, std::vector<I2CBurst>(buses.size()) };
+        busOk.assign(buses.size(), 1);
+
+        std::vector<uint16_t> need(devs.size(), 0);
+        for (uint16_t i : due) need[entries[i].dev] |= entries[i].mask;
+
+        for (size_t d = 0; d < devs.size(); d++) {
+            if (!need[d]) continue;
+            I2CBurst &burst = slot.bursts[devs[d].bus];
+            bool a = need[d] & 0x00FF, b = need[d] & 0xFF00;
+            if (a && b) devs[d].mcp->burstRead(burst, MCP23017::GPIOA, devs[d].gpio, 2);
+            else if (a) devs[d].mcp->burstRead(burst, MCP23017::GPIOA, &devs[d].gpio[0], 1);
+            else devs[d].mcp->burstRead(burst, MCP23017::GPIOB, &devs[d].gpio[1], 1);
+        }
+        return slot;
+    }
+};
+
+
+/* BusScheduler bus(mcp.handle());
+ * bus.start();
+ * I2CBurst b; mcp.burstWrite(b, MCP23017::OLATA, &value, 1);
+ * bus.submit(BUS_URGENT, std::move(b), [](bool ok) { ... });
+ * Read destinations in a submitted burst must stay valid until its done handler ran.
+ */
+class BusScheduler {
+public:
+    using Done = std::function<void(bool ok)>;
+
+    static constexpr size_t CLASSES = 4;
+
+    explicit BusScheduler(int fd, size_t sliceMessages = 8) : fd(fd), slice(sliceMessages < 2 ? 2 : sliceMessages) {
+        aging[BUS_URGENT]     = std::chrono::microseconds(0);
+        aging[BUS_INTERRUPT]  = std::chrono::microseconds(0);
+        aging[BUS_POLLING]    = std::chrono::microseconds(50000);
+        aging[BUS_DIAGNOSTIC] = std::chrono::microseconds(200000);
+    }
+
+    ~BusScheduler() { stop(); }
+
+    BusScheduler(const BusScheduler &) = delete;
+    BusScheduler &operator=(const BusScheduler &) = delete;
+
+
+    // A job of cls that waited longer than limit gets the next slice before higher classes (0 = never aged).
+    void setAging(bus_Class cls, std::chrono::microseconds limit) {
+        std::lock_guard<std::mutex> lock(mutex);
+        aging[cls % CLASSES] = limit;
+    }
+
+
+    void submit(bus_Class cls, I2CBurst &&burst, Done done = nullptr) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queues[cls % CLASSES].push_back({ std::move(burst), std::move(done), std::chrono::steady_clock::now(), 0, false });
+        }
+        wake.notify_one();
+    }
+
+
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t n = 0;
+        for (auto &q : queues) n += q.size();
+        return n;
+    }
+
+
+    BusClassStats stats(bus_Class cls) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stat[cls % CLASSES];
+    }
+
+
+    /* Sends one slice of the most urgent job. After every slice the choice is made again,
+     * so a new urgent job goes next. Returns false if nothing was pending.
+     */
+    bool step() {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto now = std::chrono::steady_clock::now();
+
+        size_t cls = CLASSES;
+        bool aged = false;
+        for (size_t c = CLASSES; c-- > 0; ) {
+            if (queues[c].empty() || aging[c].count() == 0) continue;
+            if (now - queues[c].front().queued > aging[c]) {
+                cls = c;
+                aged = true;
+                break;
+            }
+        }
+        if (cls == CLASSES) for (size_t c = 0; c < CLASSES; c++) if (!queues[c].empty()) { cls = c; break; }
+        if (cls == CLASSES) return false;
+
+        Job &job = queues[cls].front();
+        BusClassStats &st = stat[cls];
+        if (!job.started) {
+            auto delay = std::chrono::duration_cast<std::chrono::nanoseconds>(now - job.queued);
+            job.started = true;
+            st.jobs++;
+            if (delay > st.maxDelay) st.maxDelay = delay;
+            st.meanDelay += (delay - st.meanDelay) / int64_t(st.jobs);
+        }
+        st.slices++;
+        if (aged) {
+            st.aged++;
+            job.queued = now;   // One slice per aging limit, then higher classes come first again
+        }
+        lock.unlock();
+
+        // Only this thread removes jobs, pushes from submit() keep the reference valid.
+        bool ok = true;
+        job.next = job.burst.runSlice(fd, job.next, slice, ok);
+        bool done = !ok || job.next >= job.burst.size();
+
+        if (done) {
+            Done handler = std::move(job.done);
+            lock.lock();
+            queues[cls].pop_front();
+            lock.unlock();
+            if (handler) handler(ok);
+        }
+        return true;
+    }
+
+
+    void start() {
+        if (worker.joinable()) return;
+        running = true;
+        worker = std::thread([this] {
+            while (running) {
+                if (step()) continue;
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return !running || anyQueued(); });
+            }
+        });
+    }
+
+
+    void stop() {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+
+private:
+    struct Job {
+        I2CBurst burst;
+        Done done;
+        std::chrono::steady_clock::time_point queued;
+        size_t next;   // Next message to send
+        bool started;
+    };
+
+    int fd;
+    size_t slice;
+    std::deque<Job> queues[CLASSES];
+    std::chrono::microseconds aging[CLASSES];
+    BusClassStats stat[CLASSES];
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::thread worker;
+    std::atomic<bool> running{false};
+
+    bool anyQueued() const {
+        for (auto &q : queues) if (!q.empty()) return true;
+        return false;
+    }
+};
+
+
+/* EdfScheduler edf(mcp.handle(), 400000);
+ * size_t t = edf.addPeriodic(std::chrono::microseconds(2000), std::chrono::microseconds(1000),
+ *                            [&](I2CBurst &b) { mcp.burstWrite(b, MCP23017::OLATA, &next, 1); });
+ * if (t == SIZE_MAX) ...   // Does not fit on the bus
+ * edf.run(running);
+ */
+class EdfScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Build = std::function<void(I2CBurst &)>;  // Queues the messages of one job
+    using Done  = std::function<void(bool ok)>;
+
+    explicit EdfScheduler(int fd, uint32_t clockHz = 100000) : fd(fd), clock(clockHz) {}
+
+
+    // Admission warns above this load, default 0.7. Above 1.0 tasks are rejected.
+    void setLoadLimit(double limit) { warnLimit = limit; }
+
+    // Sum of cost / min(deadline, period) over all periodic tasks, plus blocking by the longest job.
+    double load() const { return density + blocking(); }
+
+
+    /* Periodic task, released every period with a relative deadline (0 = period).
+     * build() is called once here to estimate the bus time. Returns the task id, SIZE_MAX if rejected.
+     */
+    size_t addPeriodic(std::chrono::microseconds period, std::chrono::microseconds deadline, Build build, Done done = nullptr) {
+        if (period.count() <= 0 || !build) {
+            std::cerr << "Invalid input: addPeriodic(period > 0, deadline, build)" << std::endl;
+            return SIZE_MAX;
+        }
+        if (deadline.count() <= 0 || deadline > period) deadline = period;
+
+        I2CBurst sample;
+        build(sample);
+        auto cost = busTime(sample, clock);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        double share = double(cost.count()) / (double(deadline.count()) * 1000.0);
+        double total = density + share + double(std::max(cost, longest).count()) / (double(std::min(deadline, shortest).count()) * 1000.0);
+
+        try {
+           if (total > 1.0) throw std::runtime_error("EDF task rejected, bus load would be " + std::to_string(total));
+        }
+        catch (const std::runtime_error& e) {
+           std::cerr << "Error: " << e.what() << std::endl;
+           return SIZE_MAX;
+        }
+        if (total > warnLimit) std::cerr << "Warning: EDF bus load " << total << " above limit " << warnLimit << std::endl;
+
+        density += share;
+        if (cost > longest) longest = cost;
+        if (deadline < shortest) shortest = deadline;
+
+        Task t{ period, deadline, std::move(build), std::move(done), Clock::now(), EdfTaskStats() };
+        t.stats.cost = cost;
+        tasks.push_back(std::move(t));
+        return tasks.size() - 1;
+    }
+
+
+    // One-shot job with an absolute deadline. Its runs and misses count under oneShotStats().
+    void submit(I2CBurst &&burst, Clock::time_point deadline, Done done = nullptr) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            push({ std::move(burst), std::move(done), deadline, SIZE_MAX });
+        }
+        wake.notify_one();
+    }
+
+
+    EdfTaskStats stats(size_t task) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return task < tasks.size() ? tasks[task].stats : EdfTaskStats();
+    }
+
+    EdfTaskStats oneShotStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return oneShot;
+    }
+
+
+    /* Releases due periodic jobs and runs the pending job with the earliest deadline.
+     * A task that fell behind releases only its latest period, the skipped ones count as overruns.
+     * A transaction is not interrupted once started. Returns false if nothing was pending.
+     */
+    bool step() {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto now = Clock::now();
+        released.clear();
+        for (size_t i = 0; i < tasks.size(); i++) {
+            Task &t = tasks[i];
+            if (t.release > now) continue;
+            auto skipped = (now - t.release) / t.period;
+            t.release += skipped * t.period;
+            t.stats.overruns += uint64_t(skipped);
+            released.push_back({ { I2CBurst(), nullptr, t.release + t.deadline, i }, t.build });
+            t.release += t.period;
+        }
+
+        // build() may take its time or lock on its own, it runs without the scheduler lock.
+        if (!released.empty()) {
+            lock.unlock();
+            for (auto &r : released) r.second(r.first.burst);
+            lock.lock();
+            for (auto &r : released) push(std::move(r.first));
+        }
+        if (heap.empty()) return false;
+
+        std::pop_heap(heap.begin(), heap.end(), later);
+        Job job = std::move(heap.back());
+        heap.pop_back();
+        lock.unlock();
+
+        bool ok = job.burst.empty() || job.burst.run(fd);
+        auto late = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - job.deadline);
+
+        lock.lock();
+        EdfTaskStats &st = job.task < tasks.size() ? tasks[job.task].stats : oneShot;
+        if (st.runs == 0 || late > st.worstLateness) st.worstLateness = late;
+        st.runs++;
+        if (late.count() > 0) st.misses++;
+        Done handler = job.task < tasks.size() ? tasks[job.task].done : job.done;
+        lock.unlock();
+
+        if (handler) handler(ok);
+        return true;
+    }
+
+
+    /* Runs jobs until running is false. While idle it waits for the next release or a submit(),
+     * at most 10 ms so a cleared running flag is seen.
+     */
+    void run(std::atomic<bool> &running) {
+        {
+            // Periods count from the start of the loop, not from addPeriodic().
+            std::lock_guard<std::mutex> lock(mutex);
+            auto now = Clock::now();
+            for (auto &t : tasks) t.release = now;
+        }
+        while (running) {
+            if (step()) continue;
+            std::unique_lock<std::mutex> lock(mutex);
+            Clock::time_point next = Clock::now() + std::chrono::milliseconds(10);
+            for (auto &t : tasks) if (t.release < next) next = t.release;
+            wake.wait_until(lock, next, [this] { return !heap.empty(); });
+        }
+    }
+
+
+private:
+    struct Task {
+        std::chrono::microseconds period;
+        std::chrono::microseconds deadline;
+        Build build;
+        Done done;
+        Clock::time_point release;  // Next release
+        EdfTaskStats stats;
+    };
+
+    struct Job {
+        I2CBurst burst;
+        Done done;
+        Clock::time_point deadline;
+        size_t task;  // SIZE_MAX = one-shot
+    };
+
+    int fd;
+    uint32_t clock;
+    double warnLimit = 0.7;
+    double density = 0.0;
+    std::chrono::nanoseconds longest{0};
+    std::chrono::microseconds shortest = std::chrono::microseconds::max();
+    std::vector<Task> tasks;
+    std::vector<Job> heap;
+    std::vector<std::pair<Job, Build>> released;   // Only used by the thread in step()
+    EdfTaskStats oneShot;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+
+    static bool later(const Job &a, const Job &b) { return a.deadline > b.deadline; }
+
+    void push(Job &&job) {
+        heap.push_back(std::move(job));
+        std::push_heap(heap.begin(), heap.end(), later);
+    }
+
+    // A started transaction can not be preempted, the longest one may block the tightest deadline.
+    double blocking() const {
+        if (tasks.empty()) return 0.0;
+        return double(longest.count()) / (double(shortest.count()) * 1000.0);
+    }
+};
@@ -0,0 +1,311 @@
+/**
+ * @file MCP23017Shm.hpp
+ * @brief Shared memory state mirror for read-mostly consumers.
+ *
+ * One owner process publishes the latest GPIO/OLAT/INTF snapshot of each device with timestamps and counters.
+ * Every device slot is guarded by its own seqlock, so any number of reader processes can map the segment
+ * and read pin states without syscalls and without bus traffic.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "MCP23017.hpp"
+
+static const char *const SHM_NAME = "/mcp23017";
+
+struct ShmSnapshot {
+    uint8_t bus;
+    uint8_t address;
+    uint16_t gpio;
+    uint16_t olat;
+    uint16_t intf;
+    uint16_t iodir;
+    uint64_t timestamp;  // CLOCK_MONOTONIC nanoseconds of the last update
+    uint64_t updates;
+    uint64_t changes;    // Updates in which GPIO changed
+};
+
+struct ShmBusStats {
+    char name[32];
+    uint64_t transactions;
+    uint64_t errors;
+    uint64_t bytes;
+};
+
+
+struct ShmSegment {
+    static constexpr uint32_t MAGIC = 0x4D435031;  // "MCP1"
+    static constexpr uint32_t MAX_DEVICES = 128;
+    static constexpr uint32_t MAX_BUSES = 8;
+
+    struct Device {
+        std::atomic<uint32_t> seq;
+        std::atomic<uint8_t> bus, address;
+        std::atomic<uint16_t> gpio, olat, intf, iodir;
+        std::atomic<uint64_t> timestamp, updates, changes;
+    };
+
+    struct Bus {
+        char name[32];
+        std::atomic<uint64_t> transactions, errors, bytes;
+    };
+
+    // The segment is shared between processes, a lock-based fallback (libatomic) would only lock within one.
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "ShmSegment needs lock-free 64-bit atomics");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "ShmSegment needs lock-free 32-bit atomics");
+
+    struct Layout {
+        std::atomic<uint32_t> magic;
+        std::atomic<uint32_t> devices;
+        std::atomic<uint32_t> buses;
+        std::atomic<uint32_t> owner;
+        Bus bus[MAX_BUSES];
+        Device device[MAX_DEVICES];
+    };
+};
+
+
+class ShmPublisher {
+public:
+
+    explicit ShmPublisher(const std::string &name = SHM_NAME) : name(name) {
+        int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+
+        try {
+           if (fd < 0) throw std::runtime_error("Shared memory open failed");
+           if (ftruncate(fd, sizeof(ShmSegment::Layout)) < 0) throw std::runtime_error("Shared memory resize failed");
+
+           void *p = mmap(nullptr, sizeof(ShmSegment::Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+           if (p == MAP_FAILED) throw std::runtime_error("Shared memory map failed");
+
+           seg = static_cast<ShmSegment::Layout *>(p);
+           std::memset(p, 0, sizeof(ShmSegment::Layout));
+           seg->owner.store(uint32_t(getpid()), std::memory_order_relaxed);
+           seg->magic.store(ShmSegment::MAGIC, std::memory_order_release);
+        }
+        catch (const std::runtime_error& e) {
+           std::cerr << "Error: " << e.what() << std::endl;
+        }
+        if (fd >= 0) close(fd);
+    }
+
+    ~ShmPublisher() {
+        if (!seg) return;
+        munmap(seg, sizeof(ShmSegment::Layout));
+        shm_unlink(name.c_str());
+    }
+
+    ShmPublisher(const ShmPublisher &) = delete;
+    ShmPublisher &operator=(const ShmPublisher &) = delete;
+
+
+    // Returns the slot of the device, -1 if the segment is full.
+    int addDevice(const MCP23017 &mcp) {
+        if (!seg) return -1;
+        uint32_t n = seg->devices.load(std::memory_order_relaxed);
+        if (n >= ShmSegment::MAX_DEVICES) return -1;
+
+        int bus = busSlot(mcp.device());
+        if (bus < 0) return -1;
+
+        ShmSegment::Device &d = seg->device[n];
+        d.bus.store(uint8_t(bus), std::memory_order_relaxed);
+        d.address.store(mcp.address(), std::memory_order_relaxed);
+        devs.push_back({ &mcp, {0, 0, 0, 0, 0, 0, 0, 0} });
+        seg->devices.store(n + 1, std::memory_order_release);
+        return int(n);
+    }
+
+
+    void publish(int slot, uint16_t gpio, uint16_t olat, uint16_t intf, uint16_t iodir) {
+        if (!seg || slot < 0 || uint32_t(slot) >= seg->devices.load(std::memory_order_relaxed)) return;
+        ShmSegment::Device &d = seg->device[slot];
+
+        uint32_t s = d.seq.load(std::memory_order_relaxed);
+        d.seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        if (d.gpio.load(std::memory_order_relaxed) != gpio) d.changes.fetch_add(1, std::memory_order_relaxed);
+        d.gpio.store(gpio, std::memory_order_relaxed);
+        d.olat.store(olat, std::memory_order_relaxed);
+        d.intf.store(intf, std::memory_order_relaxed);
+        d.iodir.store(iodir, std::memory_order_relaxed);
+        d.timestamp.store(now(), std::memory_order_relaxed);
+        d.updates.fetch_add(1, std::memory_order_relaxed);
+
+        d.seq.store(s + 2, std::memory_order_release);
+    }
+
+
+    // Bus of the device slot, 0xFF for an invalid slot or without a segment (ignored by countTransaction()).
+    uint8_t busIndex(int slot) const {
+        if (!seg || slot < 0 || uint32_t(slot) >= seg->devices.load(std::memory_order_relaxed)) return 0xFF;
+        return seg->device[slot].bus.load(std::memory_order_relaxed);
+    }
+
+
+    void countTransaction(uint8_t bus, bool ok, uint64_t bytes) { countTransactions(bus, 1, ok ? 0 : 1, bytes); }
+
+
+    // Several transactions at once, e.g. the counter deltas of a service that runs its own bursts.
+    void countTransactions(uint8_t bus, uint64_t transactions, uint64_t errors, uint64_t bytes) {
+        if (!seg || bus >= seg->buses.load(std::memory_order_relaxed)) return;
+        ShmSegment::Bus &b = seg->bus[bus];
+        b.transactions.fetch_add(transactions, std::memory_order_relaxed);
+        b.bytes.fetch_add(bytes, std::memory_order_relaxed);
+        if (errors) b.errors.fetch_add(errors, std::memory_order_relaxed);
+    }
+
+
+    /* Reads INTF, GPIO, OLAT and IODIR of all added devices, one transaction per bus, and publishes them.
+     * Note: reading GPIO releases a pending interrupt, use publish() when an interrupt service owns the chips.
+     */
+    void sample() {
+        uint32_t buses = seg ? seg->buses.load(std::memory_order_relaxed) : 0;
+        for (uint8_t b = 0; b < buses; b++) {
+            burst.clear();
+            int fd = -1;
+            for (auto &d : devs) {
+                if (busOf(d) != b) continue;
+                fd = d.mcp->handle();
+                d.mcp->burstRead(burst, MCP23017::IODIRA, &d.regs[0], 2);
+                d.mcp->burstRead(burst, MCP23017::INTFA, &d.regs[2], 2);
+                d.mcp->burstRead(burst, MCP23017::GPIOA, &d.regs[4], 4);
+            }
+            if (fd < 0) continue;
+
+            bool ok = burst.run(fd);
+            countTransaction(b, ok, burst.wireBytes());
+            if (!ok) continue;
+
+            for (size_t i = 0; i < devs.size(); i++) {
+                const uint8_t *r = devs[i].regs;
+                if (busOf(devs[i]) == b) publish(int(i), word(r + 4), word(r + 6), word(r + 2), word(r));
+            }
+        }
+    }
+
+
+private:
+    struct Source {
+        const MCP23017 *mcp;
+        uint8_t regs[8];
+    };
+
+    std::string name;
+    ShmSegment::Layout *seg = nullptr;
+    std::vector<Source> devs;
+    I2CBurst burst;
+
+    static uint16_t word(const uint8_t *r) { return (uint16_t(r[1]) << 8) | r[0]; }
+
+    static uint64_t now() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+    }
+
+    uint8_t busOf(const Source &s) const { return busIndex(int(&s - devs.data())); }
+
+    int busSlot(const std::string &dev) {
+        uint32_t n = seg->buses.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < n; i++) {
+            if (std::strncmp(seg->bus[i].name, dev.c_str(), sizeof(seg->bus[i].name) - 1) == 0) return int(i);
+        }
+        if (n >= ShmSegment::MAX_BUSES) return -1;
+        std::strncpy(seg->bus[n].name, dev.c_str(), sizeof(seg->bus[n].name) - 1);
+        seg->buses.store(n + 1, std::memory_order_release);
+        return int(n);
+    }
+};
+
+
+class ShmReader {
+public:
+
+    explicit ShmReader(const std::string &name = SHM_NAME) {
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+
+        try {
+           if (fd < 0) throw std::runtime_error("Shared memory open failed, is the owner running?");
+
+           void *p = mmap(nullptr, sizeof(ShmSegment::Layout), PROT_READ, MAP_SHARED, fd, 0);
+           if (p == MAP_FAILED) throw std::runtime_error("Shared memory map failed");
+
+           seg = static_cast<const ShmSegment::Layout *>(p);
+           if (seg->magic.load(std::memory_order_acquire) != ShmSegment::MAGIC) throw std::runtime_error("Shared memory has wrong format");
+        }
+        catch (const std::runtime_error& e) {
+           std::cerr << "Error: " << e.what() << std::endl;
+        }
+        if (fd >= 0) close(fd);
+    }
+
+    ~ShmReader() { if (seg) munmap(const_cast<ShmSegment::Layout *>(seg), sizeof(ShmSegment::Layout)); }
+
+    ShmReader(const ShmReader &) = delete;
+    ShmReader &operator=(const ShmReader &) = delete;
+
+
+    bool valid() const { return seg != nullptr; }
+
+    uint32_t devices() const { return seg ? seg->devices.load(std::memory_order_acquire) : 0; }
+
+    uint32_t buses() const { return seg ? seg->buses.load(std::memory_order_acquire) : 0; }
+
+    uint32_t owner() const { return seg ? seg->owner.load(std::memory_order_relaxed) : 0; }
+
+
+    // Consistent copy of one device slot, retries while the owner is writing it.
+    bool read(uint32_t slot, ShmSnapshot &out) const {
+        if (slot >= devices()) return false;
+        const ShmSegment::Device &d = seg->device[slot];
+
+        for (int retry = 0; retry < 10000; retry++) {
+            uint32_t s1 = d.seq.load(std::memory_order_acquire);
+            if (s1 & 1) continue;
+
+            out.bus       = d.bus.load(std::memory_order_relaxed);
+            out.address   = d.address.load(std::memory_order_relaxed);
+            out.gpio      = d.gpio.load(std::memory_order_relaxed);
+            out.olat      = d.olat.load(std::memory_order_relaxed);
+            out.intf      = d.intf.load(std::memory_order_relaxed);
+            out.iodir     = d.iodir.load(std::memory_order_relaxed);
+            out.timestamp = d.timestamp.load(std::memory_order_relaxed);
+            out.updates   = d.updates.load(std::memory_order_relaxed);
+            out.changes   = d.changes.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (d.seq.load(std::memory_order_relaxed) == s1) return true;
+        }
+        return false;  // Owner stopped in the middle of an update
+    }
+
+
+    bool busStats(uint32_t bus, ShmBusStats &out) const {
+        if (bus >= buses()) return false;
+        const ShmSegment::Bus &b = seg->bus[bus];
+        std::memcpy(out.name, b.name, sizeof(out.name));
+        out.transactions = b.transactions.load(std::memory_order_relaxed);
+        out.errors       = b.errors.load(std::memory_order_relaxed);
+        out.bytes        = b.bytes.load(std::memory_order_relaxed);
+        return true;
+    }
+
+
+private:
+    const ShmSegment::Layout *seg = nullptr;
+};
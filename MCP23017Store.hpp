@@ -0,0 +1,273 @@
+/**
+ * @file MCP23017Store.hpp
+ * @brief Central structure-of-arrays state store for many MCP23017 expanders.
+ *
+ * IODIR, GPPU, OLAT, GPIO, INTF and INTCAP of all devices are kept as separate contiguous arrays
+ * indexed by device id, together with update and change timestamps. Fleet-wide questions such as
+ * "which outputs are on" or "which inputs changed since T" become linear scans over one array.
+ * StoreView is a thin handle with the familiar pin functions that works on the store instead of the bus;
+ * refresh() and flush() synchronize the store with the chips, one transaction per bus.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#pragma once
+
+#include <ctime>
+
+#include "MCP23017.hpp"
+#include "MCP23017Fleet.hpp"
+
+class StoreView;
+
+
+class StateStore {
+public:
+
+    // Reads the current registers of the chip into the store. Returns the device id.
+    uint32_t add(MCP23017 &mcp) {
+        uint32_t id = uint32_t(devs.size());
+        size_t bus = 0;
+        while (bus < buses.size() && buses[bus].mcp->device() != mcp.device()) bus++;
+        if (bus == buses.size()) buses.push_back({ &mcp, I2CBurst(), true });
+
+        devs.push_back({ &mcp, bus });
+        size_t n = devs.size();
+        for (FleetBits *a : { &iodirs, &gppus, &olats, &gpios, &intfs, &intcaps, &dirtyOut, &dirtyCfg }) a->resize(n);
+        updated.resize(n, 0);
+        changed.resize(n, 0);
+        xfer.resize(n * XFER);
+
+        uint8_t *x = &xfer[id * XFER];
+        I2CBurst burst;
+        mcp.burstRead(burst, MCP23017::IODIRA, x, 2);
+        mcp.burstRead(burst, MCP23017::GPPUA, x + 2, 2);
+        mcp.burstRead(burst, MCP23017::GPIOA, x + 4, 4);
+        if (burst.run(mcp.handle())) {
+            iodirs[id] = word(x);
+            gppus[id]  = word(x + 2);
+            gpios[id]  = word(x + 4);
+            olats[id]  = word(x + 6);
+            updated[id] = changed[id] = now();
+        }
+        return id;
+    }
+
+
+    size_t size() const { return devs.size(); }
+
+    MCP23017 &device(uint32_t id) { return *devs[id].mcp; }
+
+    StoreView view(uint32_t id);
+
+
+    const FleetBits &iodir() const  { return iodirs; }
+    const FleetBits &gppu() const   { return gppus; }
+    const FleetBits &olat() const   { return olats; }
+    const FleetBits &gpio() const   { return gpios; }
+    const FleetBits &intf() const   { return intfs; }
+    const FleetBits &intcap() const { return intcaps; }
+
+    // CLOCK_MONOTONIC nanoseconds of the last refresh and of the last GPIO change per device.
+    const std::vector<uint64_t> &updatedAt() const { return updated; }
+    const std::vector<uint64_t> &changedAt() const { return changed; }
+
+    static uint64_t now() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+    }
+
+
+    void setOutputs(uint32_t id, uint16_t bits, uint16_t mask) {
+        uint16_t v = (olats[id] & ~mask) | (bits & mask);
+        dirtyOut[id] |= v ^ olats[id];
+        olats[id] = v;
+    }
+
+
+    // inputs = IODIR bits (1 = input), pullups = GPPU bits, both under mask.
+    void setDirections(uint32_t id, uint16_t inputs, uint16_t pullups, uint16_t mask) {
+        iodirs[id] = (iodirs[id] & ~mask) | (inputs & mask);
+        gppus[id]  = (gppus[id] & ~mask) | (pullups & mask);
+        dirtyCfg[id] |= mask;
+    }
+
+
+    /* Reads INTF, INTCAP, GPIO and OLAT of every device (eight consecutive registers), one transaction per bus.
+     * Reading GPIO releases pending interrupts, the flags stay available in intf()/intcap().
+     */
+    bool refresh() {
+        for (auto &b : buses) b.burst.clear();
+        for (uint32_t id = 0; id < devs.size(); id++) {
+            devs[id].mcp->burstRead(buses[devs[id].bus].burst, MCP23017::INTFA, &xfer[id * XFER], 8);
+        }
+        bool ok = runAll();
+
+        uint64_t t = now();
+        for (uint32_t id = 0; id < devs.size(); id++) {
+            if (!buses[devs[id].bus].ok) continue;
+            const uint8_t *x = &xfer[id * XFER];
+            uint16_t g = word(x + 4);
+            if (g != gpios[id]) changed[id] = t;
+            intfs[id]   = word(x);
+            intcaps[id] = word(x + 2);
+            gpios[id]   = g;
+            if (!dirtyOut[id]) olats[id] = word(x + 6);
+            updated[id] = t;
+        }
+        return ok;
+    }
+
+
+    // Writes pending direction, pull-up and output changes, one transaction per bus.
+    bool flush() {
+        for (auto &b : buses) b.burst.clear();
+
+        dirtyCfg.forEachNonZero([&](size_t id, uint16_t) {
+            uint8_t *x = &xfer[id * XFER + 8];
+            setWord(x, iodirs[id]);
+            setWord(x + 2, gppus[id]);
+            I2CBurst &burst = buses[devs[id].bus].burst;
+            devs[id].mcp->burstWrite(burst, MCP23017::IODIRA, x, 2);
+            devs[id].mcp->burstWrite(burst, MCP23017::GPPUA, x + 2, 2);
+        });
+        dirtyOut.forEachNonZero([&](size_t id, uint16_t diff) {
+            uint8_t *x = &xfer[id * XFER + 12];
+            setWord(x, olats[id]);
+            I2CBurst &burst = buses[devs[id].bus].burst;
+            if ((diff & 0x00FF) && (diff & 0xFF00)) devs[id].mcp->burstWrite(burst, MCP23017::OLATA, x, 2);
+            else if (diff & 0x00FF) devs[id].mcp->burstWrite(burst, MCP23017::OLATA, x, 1);
+            else devs[id].mcp->burstWrite(burst, MCP23017::OLATB, x + 1, 1);
+        });
+
+        bool ok = runAll();
+        if (ok) {
+            dirtyCfg.fill(0);
+            dirtyOut.fill(0);
+        }
+        return ok;
+    }
+
+
+    // f(id, bits) for every device with output pins that are on (OLAT high and IODIR output).
+    template <class F>
+    size_t outputsOn(F f) {
+        scratch.resize(devs.size());
+        FleetBits::andNotOf(scratch, olats, iodirs);
+        return scratch.forEachNonZero(f);
+    }
+
+
+    // f(id, gpio) for every device whose inputs changed after t.
+    template <class F>
+    size_t changedSince(uint64_t t, F f) const {
+        size_t n = 0;
+        for (uint32_t id = 0; id < changed.size(); id++) {
+            if (changed[id] <= t) continue;
+            f(id, gpios[id]);
+            n++;
+        }
+        return n;
+    }
+
+
+    // f(id, flags) for every device with interrupt flags from the last refresh.
+    template <class F>
+    size_t flagged(F f) const { return intfs.forEachNonZero(f); }
+
+
+private:
+    static constexpr size_t XFER = 16;  // Transfer bytes per device: 8 read, 4 config, 2 output
+
+    struct Dev {
+        MCP23017 *mcp;
+        size_t bus;
+    };
+
+    struct Bus {
+        MCP23017 *mcp;   // First device on the bus path, its fd runs the transactions
+        I2CBurst burst;
+        bool ok;
+    };
+
+    std::vector<Dev> devs;
+    std::vector<Bus> buses;
+    FleetBits iodirs, gppus, olats, gpios, intfs, intcaps;
+    FleetBits dirtyOut, dirtyCfg, scratch;
+    std::vector<uint64_t> updated, changed;
+    std::vector<uint8_t> xfer;
+
+    static uint16_t word(const uint8_t *r) { return (uint16_t(r[1]) << 8) | r[0]; }
+
+    static void setWord(uint8_t *r, uint16_t v) {
+        r[0] = uint8_t(v);
+        r[1] = uint8_t(v >> 8);
+    }
+
+    bool runAll() {
+        bool ok = true;
+        for (auto &b : buses) {
+            b.ok = b.burst.empty() || b.burst.run(b.mcp->handle());
+            ok &= b.ok;
+        }
+        return ok;
+    }
+};
+
+
+// Thin handle into the store: no state of its own, no bus traffic until StateStore::flush()/refresh().
+class StoreView {
+public:
+
+    StoreView(StateStore &store, uint32_t id) : store(&store), devId(id) {}
+
+    uint32_t id() const { return devId; }
+
+
+    void pinMode(uint8_t pin, pin_Mode mode) {
+        if (pin > 15) {
+            std::cerr << "Valid Pinnums 0-15" << std::endl;
+            return;
+        }
+        uint16_t bit = uint16_t(1) << pin;
+        store->setDirections(devId, mode == OUTPUT ? 0 : bit, mode == INPUT_PULLUP ? bit : 0, bit);
+    }
+
+
+    void pinWrite(uint8_t pin, pin_Value value) {
+        if (pin > 15 || (value != HIGH && value != LOW)) {
+            std::cerr << "Invalid input: pinWrite(pin, HIGH/LOW)" << std::endl;
+            return;
+        }
+        uint16_t bit = uint16_t(1) << pin;
+        store->setOutputs(devId, value == HIGH ? bit : 0, bit);
+    }
+
+
+    void portWrite(uint16_t bits, uint16_t mask = 0xFFFF) { store->setOutputs(devId, bits, mask); }
+
+
+    pin_Value pinRead(uint8_t pin) const {
+        if (pin > 15) return ERROR;
+        return ((store->gpio()[devId] >> pin) & 1) ? HIGH : LOW;
+    }
+
+
+    uint16_t portRead() const { return store->gpio()[devId]; }
+
+    uint16_t getInterruptFlags() const { return store->intf()[devId]; }
+
+
+private:
+    StateStore *store;
+    uint32_t devId;
+};
+
+
+inline StoreView StateStore::view(uint32_t id) { return StoreView(*this, id); }
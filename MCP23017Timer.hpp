@@ -0,0 +1,244 @@
+/**
+ * @file MCP23017Timer.hpp
+ * @brief Timed output writes for an MCP23017 expander.
+ *
+ * Pin and port writes are scheduled for absolute CLOCK_MONOTONIC times and executed by a worker thread
+ * that sleeps on a timerfd, so a sequence does not drift like a chain of sleep_for() calls.
+ * Writes due within the tolerance window go out together in one transaction, as long as they touch
+ * different pins; a later write to a pin already in the transaction waits for its own deadline.
+ * The latches are read once and then kept in a shadow, so every update is a write only transaction.
+ * The worker can run with SCHED_FIFO priority and pinned to one CPU.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <thread>
+
+#include "MCP23017.hpp"
+
+struct TimerStats {
+    uint64_t transactions = 0;
+    uint64_t writes = 0;                  // Scheduled writes executed
+    uint64_t merged = 0;                  // Writes that shared a transaction with an earlier one
+    uint64_t errors = 0;                  // Failed transactions, their writes are dropped
+    std::chrono::nanoseconds maxLate{0};  // Start of a transaction after its earliest deadline
+};
+
+
+/* OutputTimer timer(mcp);
+ * auto t = std::chrono::steady_clock::now();
+ * for (int i = 0; i < 10; i++) {
+ *     timer.schedulePinWrite(0, HIGH, t + std::chrono::milliseconds(500 * i));
+ *     timer.schedulePinWrite(0, LOW,  t + std::chrono::milliseconds(500 * i + 250));
+ * }
+ */
+class OutputTimer {
+public:
+    using Clock = std::chrono::steady_clock;  // CLOCK_MONOTONIC on Linux
+
+    explicit OutputTimer(MCP23017 &mcp, std::chrono::microseconds tolerance = std::chrono::microseconds(200))
+        : mcp(mcp), tolerance(tolerance) {
+        try {
+           tfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+           if (tfd < 0) throw std::runtime_error("timerfd create failed");
+           efd = eventfd(0, EFD_CLOEXEC);
+           if (efd < 0) throw std::runtime_error("eventfd create failed");
+        }
+        catch (const std::runtime_error& e) {
+           std::cerr << "Error: " << e.what() << std::endl;
+           return;
+        }
+        worker = std::thread(&OutputTimer::loop, this);
+    }
+
+    ~OutputTimer() {
+        if (worker.joinable()) {
+            uint64_t one = 1;
+            if (write(efd, &one, sizeof(one)) < 0) {}
+            worker.join();
+        }
+        if (tfd >= 0) close(tfd);
+        if (efd >= 0) close(efd);
+    }
+
+    OutputTimer(const OutputTimer &) = delete;
+    OutputTimer &operator=(const OutputTimer &) = delete;
+
+
+    void schedulePinWrite(uint8_t pin, pin_Value value, Clock::time_point when) {
+        if (pin > 15 || (value != HIGH && value != LOW)) {
+            std::cerr << "Invalid input: schedulePinWrite(pin 0-15, HIGH/LOW, when)" << std::endl;
+            return;
+        }
+        uint16_t bit = uint16_t(1) << pin;
+        schedulePortWrite(value == HIGH ? bit : 0, when, bit);
+    }
+
+
+    // Writes bits under mask at when. Writes for the same time run in the order they were scheduled.
+    void schedulePortWrite(uint16_t bits, Clock::time_point when, uint16_t mask = 0xFFFF) {
+        std::lock_guard<std::mutex> lock(mutex);
+        bool first = jobs.empty() || when < jobs.begin()->first;
+        jobs.insert({ when, { bits, mask } });
+        if (first) arm();
+    }
+
+
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return jobs.size();
+    }
+
+
+    void cancel() {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.clear();
+        arm();
+    }
+
+
+    TimerStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stat;
+    }
+
+
+    // SCHED_FIFO priority 1-99 for the worker, optionally pinned to cpu. Needs CAP_SYS_NICE or root.
+    bool setRealtime(int priority, int cpu = -1) {
+        if (!worker.joinable()) return false;
+        try {
+           sched_param sp{};
+           sp.sched_priority = priority;
+           if (pthread_setschedparam(worker.native_handle(), SCHED_FIFO, &sp) != 0) throw std::runtime_error("SCHED_FIFO not permitted");
+           if (cpu >= 0) {
+               cpu_set_t set;
+               CPU_ZERO(&set);
+               CPU_SET(cpu, &set);
+               if (pthread_setaffinity_np(worker.native_handle(), sizeof(set), &set) != 0) throw std::runtime_error("CPU affinity failed");
+           }
+        }
+        catch (const std::runtime_error& e) {
+           std::cerr << "Error: " << e.what() << std::endl;
+           return false;
+        }
+        return true;
+    }
+
+
+private:
+    struct Write {
+        uint16_t bits;
+        uint16_t mask;
+    };
+
+    MCP23017 &mcp;
+    std::chrono::microseconds tolerance;
+    int tfd = -1;
+    int efd = -1;
+    std::multimap<Clock::time_point, Write> jobs;
+    TimerStats stat;
+    I2CBurst burst;
+    uint8_t olat[2] = {0, 0};   // Shadow of OLATA/B, other writers to the latches are not seen after seeding
+    bool seeded = false;
+    mutable std::mutex mutex;
+    std::thread worker;
+
+    // Absolute expiry at the earliest job, disarmed when nothing is pending. Called with the mutex held.
+    void arm() {
+        itimerspec its{};
+        if (!jobs.empty()) {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(jobs.begin()->first.time_since_epoch()).count();
+            if (ns <= 0) ns = 1;
+            its.it_value.tv_sec = time_t(ns / 1000000000ll);
+            its.it_value.tv_nsec = long(ns % 1000000000ll);
+        }
+        timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, nullptr);
+    }
+
+    // Reads OLATA/B into the shadow, once and again only after a failed write.
+    bool seed() {
+        burst.clear();
+        mcp.burstRead(burst, MCP23017::OLATA, olat, 2);
+        seeded = burst.run(mcp.handle());
+        return seeded;
+    }
+
+    void loop() {
+        pollfd fds[2] = { { tfd, POLLIN, 0 }, { efd, POLLIN, 0 } };
+        while (true) {
+            if (poll(fds, 2, -1) < 0) continue;
+            if (fds[1].revents & POLLIN) return;
+            if (!(fds[0].revents & POLLIN)) continue;
+
+            uint64_t expirations;
+            if (read(tfd, &expirations, sizeof(expirations)) < 0) {}
+            fire();
+        }
+    }
+
+    /* Writes due within the tolerance window, merged in time order into one latch update.
+     * Merging stops at the first write that overlaps the pins already taken, so a short pulse on a pin
+     * is not folded into its final level.
+     */
+    void fire() {
+        uint16_t bits = 0, mask = 0;
+        size_t count = 0;
+        Clock::time_point earliest;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto limit = Clock::now() + tolerance;
+            auto it = jobs.begin();
+            if (it == jobs.end() || it->first > limit) {
+                arm();
+                return;
+            }
+            earliest = it->first;
+            for (; it != jobs.end() && it->first <= limit && !(it->second.mask & mask); it = jobs.erase(it)) {
+                bits = (bits & ~it->second.mask) | (it->second.bits & it->second.mask);
+                mask |= it->second.mask;
+                count++;
+            }
+            arm();
+        }
+
+        auto start = Clock::now();
+        bool ok = seeded || seed();
+        if (ok) {
+            uint16_t val = ((uint16_t(olat[1]) << 8 | olat[0]) & ~mask) | (bits & mask);
+            uint8_t out[2] = { uint8_t(val), uint8_t(val >> 8) };
+            burst.clear();
+            if ((mask & 0x00FF) && (mask & 0xFF00)) mcp.burstWrite(burst, MCP23017::OLATA, out, 2);
+            else if (mask & 0x00FF) mcp.burstWrite(burst, MCP23017::OLATA, &out[0], 1);
+            else mcp.burstWrite(burst, MCP23017::OLATB, &out[1], 1);
+            ok = burst.run(mcp.handle());
+            if (ok) {
+                olat[0] = out[0];
+                olat[1] = out[1];
+            }
+            else seeded = false;   // Latch state unknown, read again before the next write
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!ok) stat.errors++;
+        auto late = std::chrono::duration_cast<std::chrono::nanoseconds>(start - earliest);
+        if (late > stat.maxLate) stat.maxLate = late;
+        stat.transactions++;
+        stat.writes += count;
+        stat.merged += count - 1;
+    }
+};
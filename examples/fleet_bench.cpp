@@ -0,0 +1,126 @@
+/**
+ * @file fleet_bench.cpp
+ * @class MCP23017Fleet.hpp
+ * @brief Benchmark: fleet-wide SIMD rule evaluation and change detection against per-pin loops.
+ *
+ * Evaluates "output = input AND NOT lock, only on enabled pins" for a large fleet of expanders,
+ * once pin by pin like a pinRead/pinWrite loop, once word by word, and once with FleetProgram.
+ * Then detects a few changed inputs, once with a 16 bit loop per device, once with FleetSnapshot.
+ * Runs without hardware, the port images are random.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#include <iostream>
+#include <chrono>
+#include <random>
+
+// Include fleet images and programs.
+#include "MCP23017Fleet.hpp"
+
+// Measure a function, returns nanoseconds per call.
+template <class F>
+double measure(F f, int rounds) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / rounds;
+}
+
+int main() {
+    const int rounds = 20000;
+    std::mt19937 rng(23017);
+
+    for (size_t devices : { 64, 512, 4096 }) {
+
+        // Random inputs, locks and enable masks for every device.
+        FleetBits inputs(devices), locks(devices), enable(devices), outputs(devices), check(devices);
+        for (size_t d = 0; d < devices; d++) {
+            inputs[d] = uint16_t(rng());
+            locks[d]  = uint16_t(rng());
+            enable[d] = uint16_t(rng());
+        }
+
+        // 1. Pin by pin, like one pinRead per input and one pinWrite per output.
+        double perPin = measure([&] {
+            for (size_t d = 0; d < devices; d++) {
+                for (int pin = 0; pin < 16; pin++) {
+                    if (!((enable[d] >> pin) & 1)) continue;
+                    bool in   = (inputs[d] >> pin) & 1;
+                    bool lock = (locks[d] >> pin) & 1;
+                    if (in && !lock) check[d] |= uint16_t(1 << pin);
+                    else check[d] &= uint16_t(~(1 << pin));
+                }
+            }
+        }, rounds / 10);
+
+        // 2. Word by word, one 16 bit port image per step.
+        double perWord = measure([&] {
+            for (size_t d = 0; d < devices; d++) {
+                uint16_t acc = inputs[d] & ~locks[d];
+                outputs[d] = (outputs[d] & ~enable[d]) | (acc & enable[d]);
+            }
+        }, rounds);
+
+        // 3. Whole fleet with SIMD.
+        FleetProgram program;
+        uint16_t lockImage   = program.constant(locks);
+        uint16_t enableImage = program.constant(enable);
+        program.load(FleetProgram::INPUTS).andNot(lockImage).store(enableImage);
+
+        FleetBits fleet(devices);
+        double simd = measure([&] { program.evaluate(inputs, fleet); }, rounds);
+
+        // All three must give the same result.
+        bool same = true;
+        for (size_t d = 0; d < devices; d++) same &= (check[d] == outputs[d]) && (fleet[d] == outputs[d]);
+
+        std::cout << devices << " devices (" << devices * 16 << " pins), " << fleet_simd::NAME << "\n";
+        std::cout << "  per pin : " << perPin << " ns/scan\n";
+        std::cout << "  per word: " << perWord << " ns/scan\n";
+        std::cout << "  fleet   : " << simd << " ns/scan  (" << perPin / simd << "x faster than per pin)\n";
+        std::cout << "  results " << (same ? "match" : "DIFFER") << "\n";
+
+        // Change detection: 4 pins change per scan, somewhere in the fleet.
+        FleetSnapshot snap(devices);
+        std::vector<uint16_t> last(devices, 0), now(devices, 0);
+        size_t loopEvents = 0, snapEvents = 0;
+        int tick = 0;
+
+        auto mutate = [&] {
+            for (int k = 0; k < 4; k++) {
+                size_t d = (tick * 7919 + k * 104729) % devices;
+                now[d] ^= uint16_t(1 << ((tick + k) & 15));
+                snap.set(d, now[d]);
+            }
+            tick++;
+        };
+
+        // Per device: compare, then loop over 16 bits like getInterruptPins.
+        double loop = measure([&] {
+            mutate();
+            for (size_t d = 0; d < devices; d++) {
+                uint16_t changed = now[d] ^ last[d];
+                for (int pin = 0; pin < 16; pin++) if (changed & (1 << pin)) loopEvents++;
+                last[d] = now[d];
+            }
+        }, rounds);
+
+        // Catch the snapshot up with the changes made during the loop run.
+        snap.changes([](const FleetEvent &) {});
+
+        double vect = measure([&] {
+            mutate();
+            snapEvents += snap.changes([](const FleetEvent &) {});
+        }, rounds);
+
+        std::cout << "  changes loop    : " << loop << " ns/scan, " << loopEvents << " events\n";
+        std::cout << "  changes snapshot: " << vect << " ns/scan, " << snapEvents << " events\n\n";
+    }
+    return 0;
+}
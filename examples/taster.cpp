@@ -13,20 +13,24 @@
  *
  * Requires:
  *  - MCP23017 I2C 16 Bit I/O Expander Modul
+ *  - INTA or INTB wired to a host GPIO (here GPIO 17 on /dev/gpiochip0)
  *
  * GitHub: https://github.com/dsmurph/mcp23017
  */
 
 #include <iostream>
 #include <chrono>
-#include <thread>
 
-// Include class mcp23017.
+// Include class mcp23017 and the interrupt helpers.
 #include "MCP23017.hpp"
+#include "MCP23017Int.hpp"
 
 // Define a name
 const int inputPin = 8;
 
+// Host GPIO line with the INT output of the MCP23017
+const unsigned intLine = 17;
+
 // create an object
 MCP23017 mcp;
 
@@ -35,22 +39,20 @@ int main() {
     try {
         // Sets inputPin (Pin 8) as INPUT with internal PULLUP
         mcp.pinMode(inputPin, INPUT_PULLUP);
-        
-         // pinValue helper
-        pinValue val = HIGH;
-        // The loop will continue to execute as long as the condition is true.
-        while (val == HIGH) {
-          
-           // Read the Pin and passes state
-           val = mcp.pinRead(inputPin);
-           
-           // Just a short break to relieve the system
-           std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-        
-        // Button pressed, pin goes low and exits the loop.
-        std::cout << "Button pressed!\n";
-           
+
+        // INTA and INTB mirrored and active LOW, so one wire is enough.
+        mcp.intOutputMode(LOW, false, true);
+
+        // The host GPIO wakes us up, no polling of the bus while waiting.
+        HostIntLine line(intLine, "/dev/gpiochip0", LOW, true);
+        IntWaiter waiter(mcp, &line);
+
+        // Blocks until the button pulls the pin LOW, at most 60 seconds.
+        IntWaitResult r = waiter.waitForLevel(inputPin, LOW, std::chrono::seconds(60));
+
+        if (r.ok) std::cout << "Button pressed!\n";
+        else std::cout << "No button press within 60 seconds.\n";
+
     } catch (const std::exception &e) {
         std::cerr << e.what() << "\n";
     }
@@ -0,0 +1,399 @@
+/**
+ * @file mcp23017-broker.cpp
+ * @class MCP23017.hpp, MCP23017Broker.hpp
+ * @brief GPIO broker daemon: owns the I2C buses and serves many client processes over a Unix socket.
+ *
+ * Usage: mcp23017-broker [-s socket] [-p poll_ms] [-m shm_name] [-j journal] [-i /dev/i2c-1=/dev/gpiochip0:17 ...]
+ *                        /dev/i2c-1:0x20 [/dev/i2c-1:0x21 ...]
+ *
+ * Devices are numbered in command line order.
+ * With -m all devices are polled and mirrored to shared memory for mcp23017-top and other readers.
+ * With -j the output state is journaled on every flush; after a restart the devices are warm attached
+ * and restored from the journal with one transaction per bus instead of being reset.
+ * Writes from all clients are coalesced per device and flushed once per loop, one transaction per bus.
+ * Inputs of subscribed devices are read once per poll period, one transaction per bus, and fanned out.
+ * Snapshots of devices that are not polled read GPIO on demand.
+ * With -i bus=gpiochip:line the open-drain INT outputs of all chips on that bus are wired to one host GPIO.
+ * Subscribed pins of those chips interrupt on change and are served by SharedIntLine as soon as the line fires,
+ * so their events are not limited by the poll period. Buses without an INT line are polled.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#include <iostream>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <map>
+#include <memory>
+#include <sys/epoll.h>
+
+#include "MCP23017.hpp"
+#include "MCP23017Broker.hpp"
+#include "MCP23017Int.hpp"
+#include "MCP23017Journal.hpp"
+#include "MCP23017Shm.hpp"
+
+struct Device {
+    std::unique_ptr<MCP23017> mcp;
+    uint8_t gpio[2], olat[2], iodir[2], gppu[2], intf[2];
+    bool outDirty, cfgDirty;
+    int slot;       // Shared memory slot, -1 = not mirrored
+    uint16_t armed; // Pins with interrupt on change, only on buses with an INT line
+};
+
+struct IntBus {
+    std::unique_ptr<HostIntLine> line;
+    std::unique_ptr<SharedIntLine> shared;
+    size_t dev;           // First device of the bus
+    IntBusStats counted;  // Transactions of the service already in the mirror
+};
+
+struct Client {
+    int fd;
+    std::vector<uint16_t> subscribed;
+};
+
+static volatile sig_atomic_t running = 1;
+
+static void stop(int) { running = 0; }
+
+static uint16_t word(const uint8_t *r) { return (uint16_t(r[1]) << 8) | r[0]; }
+
+static void setWord(uint8_t *r, uint16_t v) {
+    r[0] = uint8_t(v);
+    r[1] = uint8_t(v >> 8);
+}
+
+
+int main(int argc, char **argv) {
+    std::string path = BROKER_SOCKET;
+    std::string shmName, journalPath;
+    int pollMs = 10;
+    std::vector<Device> devs;
+    std::map<std::string, std::vector<size_t>> buses;
+    std::vector<std::pair<std::string, uint8_t>> specs;
+    std::map<std::string, std::pair<std::string, unsigned>> intSpecs;   // Bus -> GPIO chip, line
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-s" && i + 1 < argc) path = argv[++i];
+        else if (arg == "-p" && i + 1 < argc) pollMs = std::stoi(argv[++i]);
+        else if (arg == "-m" && i + 1 < argc) shmName = argv[++i];
+        else if (arg == "-j" && i + 1 < argc) journalPath = argv[++i];
+        else if (arg == "-i" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t eq = spec.find('='), colon = spec.rfind(':');
+            if (eq == std::string::npos || colon == std::string::npos || colon < eq) {
+                std::cerr << "Invalid input: -i /dev/i2c-1=/dev/gpiochip0:17" << std::endl;
+                return 1;
+            }
+            intSpecs[spec.substr(0, eq)] = { spec.substr(eq + 1, colon - eq - 1), unsigned(std::stoul(spec.substr(colon + 1))) };
+        }
+        else {
+            size_t colon = arg.rfind(':');
+            if (colon == std::string::npos) {
+                std::cerr << "Usage: mcp23017-broker [-s socket] [-p poll_ms] [-m shm_name] [-j journal] [-i bus=gpiochip:line] /dev/i2c-1:0x20 ..." << std::endl;
+                return 1;
+            }
+            specs.push_back({ arg.substr(0, colon), uint8_t(std::stoi(arg.substr(colon + 1), nullptr, 0)) });
+        }
+    }
+    if (specs.empty() || specs.size() > 255) {
+        std::cerr << "Usage: mcp23017-broker [-s socket] [-p poll_ms] [-m shm_name] [-j journal] [-i bus=gpiochip:line] /dev/i2c-1:0x20 ..." << std::endl;
+        return 1;
+    }
+
+    // Devices are opened after all options are known, with -j they are warm attached wherever it was given.
+    for (auto &spec : specs) {
+        buses[spec.first].push_back(devs.size());
+        devs.push_back({ std::make_unique<MCP23017>(spec.second, spec.first, journalPath.empty()), {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, false, false, -1, 0 });
+    }
+
+    std::unique_ptr<ShmPublisher> mirror;
+    if (!shmName.empty()) {
+        mirror = std::make_unique<ShmPublisher>(shmName);
+        for (auto &d : devs) d.slot = mirror->addDevice(*d.mcp);
+    }
+
+    // Every transaction of the broker goes into the bus counters of the mirror.
+    auto runOn = [&](I2CBurst &b, size_t dev) {
+        bool ok = b.run(devs[dev].mcp->handle());
+        if (mirror) mirror->countTransaction(mirror->busIndex(devs[dev].slot), ok, b.wireBytes());
+        return ok;
+    };
+
+    // Warm attached devices come back from the journal, devices without a record are reset.
+    std::unique_ptr<OutputJournal> journal;
+    I2CBurst burst;
+    if (!journalPath.empty()) {
+        journal = std::make_unique<OutputJournal>(journalPath);
+        std::vector<MCP23017 *> all;
+        for (auto &d : devs) all.push_back(d.mcp.get());
+        std::cout << "mcp23017-broker: " << journal->restore(all) << " devices restored from " << journalPath << "\n";
+
+        static const uint8_t inputs[2] = { 0xFF, 0xFF };
+        for (size_t i = 0; i < devs.size(); i++) {
+            JournalImage image;
+            if (journal->lookup(*devs[i].mcp, image)) continue;
+            burst.clear();
+            devs[i].mcp->burstWrite(burst, MCP23017::IODIRA, inputs, 2);
+            runOn(burst, i);
+        }
+    }
+
+    // Initial state of all devices, one transaction per bus.
+    for (auto &bus : buses) {
+        burst.clear();
+        for (size_t i : bus.second) {
+            Device &d = devs[i];
+            d.mcp->burstRead(burst, MCP23017::IODIRA, d.iodir, 2);
+            d.mcp->burstRead(burst, MCP23017::GPPUA, d.gppu, 2);
+            d.mcp->burstRead(burst, MCP23017::GPIOA, d.gpio, 2);
+            d.mcp->burstRead(burst, MCP23017::OLATA, d.olat, 2);
+        }
+        runOn(burst, bus.second.front());
+    }
+
+
+    int listenFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+
+    if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || listen(listenFd, 16) < 0) {
+        std::cerr << "Error: Broker socket " << path << " failed" << std::endl;
+        return 1;
+    }
+
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    epoll_ctl(ep, EPOLL_CTL_ADD, listenFd, &ev);
+
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+
+    std::map<int, Client> clients;
+    auto period = std::chrono::milliseconds(pollMs);
+    auto nextPoll = std::chrono::steady_clock::now();
+    epoll_event ready[32];
+
+    auto sendTo = [](int fd, const BrokerFrame &f) { ::send(fd, &f, sizeof(f), MSG_NOSIGNAL | MSG_DONTWAIT); };
+
+    // Interrupt fan-out: the captured levels of flagged pins go straight to their subscribers.
+    std::map<int, IntBus> intLines;   // By line fd
+    std::vector<uint8_t> intDriven(devs.size(), 0);
+    for (auto &spec : intSpecs) {
+        auto bus = buses.find(spec.first);
+        if (bus == buses.end()) {
+            std::cerr << "Invalid input: -i " << spec.first << " has no devices" << std::endl;
+            continue;
+        }
+        IntBus ib;
+        ib.dev = bus->second.front();
+        ib.line = std::make_unique<HostIntLine>(spec.second.second, spec.second.first, LOW, true);
+        if (ib.line->handle() < 0) continue;
+        ib.shared = std::make_unique<SharedIntLine>(ib.line.get());
+
+        for (size_t i : bus->second) {
+            devs[i].mcp->intOutputMode(LOW, true, true);
+            intDriven[i] = 1;
+            ib.shared->add(*devs[i].mcp, [&, i](MCP23017 &, const std::vector<IntEvent> &events) {
+                Device &d = devs[i];
+                uint16_t flags = 0, levels = 0;
+                for (auto &e : events) {
+                    flags |= uint16_t(1u << e.pin);
+                    if (e.level) levels |= uint16_t(1u << e.pin);
+                }
+                setWord(d.gpio, uint16_t((word(d.gpio) & ~flags) | levels));
+                setWord(d.intf, flags);
+                for (auto &c : clients) {
+                    uint16_t mine = flags & c.second.subscribed[i];
+                    if (mine) sendTo(c.first, { BROKER_EVENT, uint8_t(i), word(d.gpio), mine, 0 });
+                }
+            });
+        }
+        ev.events = EPOLLIN;
+        ev.data.fd = ib.line->handle();
+        epoll_ctl(ep, EPOLL_CTL_ADD, ib.line->handle(), &ev);
+        intLines[ib.line->handle()] = std::move(ib);
+    }
+
+    std::cout << "mcp23017-broker: " << devs.size() << " devices on " << buses.size() << " buses, "
+              << intLines.size() << " INT lines, socket " << path << "\n";
+
+    while (running) {
+        auto now = std::chrono::steady_clock::now();
+        int timeout = now >= nextPoll ? 0 : int(std::chrono::duration_cast<std::chrono::milliseconds>(nextPoll - now).count());
+        int n = epoll_wait(ep, ready, 32, timeout);
+
+        for (int i = 0; i < n; i++) {
+            int fd = ready[i].data.fd;
+
+            auto line = intLines.find(fd);
+            if (line != intLines.end()) {
+                IntBus &ib = line->second;
+                ib.shared->wait(0);
+                if (mirror) {
+                    const IntBusStats &st = ib.shared->busStats();
+                    mirror->countTransactions(mirror->busIndex(devs[ib.dev].slot), st.transactions - ib.counted.transactions,
+                                              st.errors - ib.counted.errors, st.bytes - ib.counted.bytes);
+                    ib.counted = st;
+                }
+                continue;
+            }
+
+            if (fd == listenFd) {
+                int c;
+                while ((c = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    ev.events = EPOLLIN;
+                    ev.data.fd = c;
+                    epoll_ctl(ep, EPOLL_CTL_ADD, c, &ev);
+                    clients[c] = { c, std::vector<uint16_t>(devs.size(), 0) };
+                }
+                continue;
+            }
+
+            Client &client = clients[fd];
+            BrokerFrame f;
+            ssize_t len;
+            while ((len = recv(fd, &f, sizeof(f), 0)) == sizeof(f)) {
+                if (f.op == BROKER_INFO) {
+                    sendTo(fd, { BROKER_INFO, uint8_t(devs.size()), 0, 0, 0 });
+                    continue;
+                }
+                if (f.dev >= devs.size()) {
+                    sendTo(fd, { BROKER_ERROR, f.dev, 0, 0, f.op });
+                    continue;
+                }
+                Device &d = devs[f.dev];
+
+                switch (f.op) {
+                    case BROKER_SUBSCRIBE:
+                        client.subscribed[f.dev] = f.mask;
+                        // Interrupt on change for newly watched pins, set up once per pin.
+                        if (intDriven[f.dev]) {
+                            for (uint8_t pin = 0; pin < 16; pin++) {
+                                if (!(f.mask & ~d.armed & (1 << pin))) continue;
+                                d.mcp->intTriggerMode(pin, CHANGE);
+                                d.mcp->enableInt(pin);
+                            }
+                            d.armed |= f.mask;
+                        }
+                        break;
+                    case BROKER_WRITE:
+                        setWord(d.olat, (word(d.olat) & ~f.mask) | (f.bits & f.mask));
+                        d.outDirty = true;
+                        break;
+                    case BROKER_CONFIG:
+                        setWord(d.iodir, (word(d.iodir) & ~f.mask) | (f.bits & f.mask));
+                        setWord(d.gppu, (word(d.gppu) & ~f.mask) | (f.value & f.mask));
+                        d.cfgDirty = true;
+                        break;
+                    case BROKER_SNAPSHOT: {
+                        // Polled devices are at most one period old. Others, and interrupt driven ones
+                        // (only their flagged pins are updated), are read now.
+                        bool polled = bool(mirror);
+                        for (auto &c : clients) polled = polled || (c.second.subscribed[f.dev] && !intDriven[f.dev]);
+                        if (!polled) {
+                            uint16_t before = word(d.gpio);
+                            burst.clear();
+                            d.mcp->burstRead(burst, MCP23017::GPIOA, d.gpio, 2);
+                            if (!runOn(burst, f.dev)) {
+                                sendTo(fd, { BROKER_ERROR, f.dev, 0, 0, f.op });
+                                break;
+                            }
+                            // The GPIO read releases a pending INT, its changes are fanned out here instead.
+                            for (auto &c : clients) {
+                                uint16_t mine = (word(d.gpio) ^ before) & c.second.subscribed[f.dev];
+                                if (mine) sendTo(c.first, { BROKER_EVENT, f.dev, word(d.gpio), mine, 0 });
+                            }
+                        }
+                        sendTo(fd, { BROKER_SNAPSHOT, f.dev, word(d.gpio), word(d.olat), word(d.iodir) });
+                        break;
+                    }
+                    default:
+                        sendTo(fd, { BROKER_ERROR, f.dev, 0, 0, f.op });
+                }
+            }
+            if (len == 0 || (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                epoll_ctl(ep, EPOLL_CTL_DEL, fd, nullptr);
+                close(fd);
+                clients.erase(fd);
+            }
+        }
+
+        // Coalesced writes: one transaction per bus, each device at most once.
+        for (auto &bus : buses) {
+            burst.clear();
+            for (size_t i : bus.second) {
+                Device &d = devs[i];
+                if (d.cfgDirty) {
+                    d.mcp->burstWrite(burst, MCP23017::IODIRA, d.iodir, 2);
+                    d.mcp->burstWrite(burst, MCP23017::GPPUA, d.gppu, 2);
+                }
+                if (d.outDirty) d.mcp->burstWrite(burst, MCP23017::OLATA, d.olat, 2);
+            }
+            if (burst.empty() || !runOn(burst, bus.second.front())) continue;
+
+            for (size_t i : bus.second) {
+                Device &d = devs[i];
+                if (journal && (d.cfgDirty || d.outDirty)) journal->record(*d.mcp, { word(d.olat), word(d.iodir), word(d.gppu) });
+                d.cfgDirty = d.outDirty = false;
+            }
+        }
+
+        if (std::chrono::steady_clock::now() < nextPoll) continue;
+        nextPoll += period;
+        if (nextPoll < std::chrono::steady_clock::now()) nextPoll = std::chrono::steady_clock::now() + period;
+
+        // One input read per bus for all devices somebody listens to, interrupt driven ones only for the mirror.
+        std::vector<uint16_t> watched(devs.size(), 0), subscribed(devs.size(), 0), previous(devs.size(), 0);
+        for (auto &c : clients) for (size_t i = 0; i < devs.size(); i++) subscribed[i] |= c.second.subscribed[i];
+        for (size_t i = 0; i < devs.size(); i++) {
+            if (!intDriven[i]) watched[i] = subscribed[i];
+            previous[i] = word(devs[i].gpio);
+        }
+
+        for (auto &bus : buses) {
+            burst.clear();
+            for (size_t i : bus.second) {
+                if (!watched[i] && !mirror) continue;
+                devs[i].mcp->burstRead(burst, MCP23017::INTFA, devs[i].intf, 2);
+                devs[i].mcp->burstRead(burst, MCP23017::GPIOA, devs[i].gpio, 2);
+            }
+            if (!burst.empty()) runOn(burst, bus.second.front());
+        }
+
+        if (mirror) {
+            for (size_t i = 0; i < devs.size(); i++) {
+                mirror->publish(devs[i].slot, word(devs[i].gpio), word(devs[i].olat), word(devs[i].intf), word(devs[i].iodir));
+            }
+        }
+
+        for (size_t i = 0; i < devs.size(); i++) {
+            // Also changes of interrupt driven pins the mirror read caught first (its GPIO read clears their INT).
+            uint16_t changed = (word(devs[i].gpio) ^ previous[i]) & subscribed[i];
+            if (!changed) continue;
+            for (auto &c : clients) {
+                uint16_t mine = changed & c.second.subscribed[i];
+                if (mine) sendTo(c.first, { BROKER_EVENT, uint8_t(i), word(devs[i].gpio), mine, 0 });
+            }
+        }
+    }
+
+    for (auto &c : clients) close(c.first);
+    close(listenFd);
+    close(ep);
+    unlink(path.c_str());
+    return 0;
+}
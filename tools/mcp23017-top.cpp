@@ -0,0 +1,87 @@
+/**
+ * @file mcp23017-top.cpp
+ * @class MCP23017Shm.hpp
+ * @brief Live view of pin states and bus statistics from the shared memory mirror.
+ *
+ * Usage: mcp23017-top [-m shm_name] [-i interval_ms]
+ *
+ * Pin states come from the shared memory mirror only, the viewer causes no bus traffic.
+ * Pins: H/L = output high/low, 1/0 = input high/low, * = interrupt flag.
+ *
+ * @authors dsmurph & Lex
+ * @version 1.0.0
+ * @date 2025-11-27
+ * @license MIT
+ *
+ * GitHub: https://github.com/dsmurph/mcp23017
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+
+#include "MCP23017Shm.hpp"
+
+int main(int argc, char **argv) {
+    std::string name = SHM_NAME;
+    int intervalMs = 200;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-m" && i + 1 < argc) name = argv[++i];
+        else if (arg == "-i" && i + 1 < argc) intervalMs = std::stoi(argv[++i]);
+        else {
+            std::cerr << "Usage: mcp23017-top [-m shm_name] [-i interval_ms]" << std::endl;
+            return 1;
+        }
+    }
+
+    ShmReader shm(name);
+    if (!shm.valid()) return 1;
+
+    std::vector<uint64_t> lastBytes(ShmSegment::MAX_BUSES, 0);
+
+    while (true) {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        uint64_t now = uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+
+        std::cout << "\033[H\033[2J";
+        std::cout << "mcp23017-top  owner pid " << shm.owner() << "  " << shm.devices() << " devices\n\n";
+        std::cout << " #  bus  addr  B7      B0 A7      A0   INTF  updates  changes    age ms\n";
+
+        for (uint32_t i = 0; i < shm.devices(); i++) {
+            ShmSnapshot s;
+            if (!shm.read(i, s)) continue;
+
+            std::cout << std::setw(2) << i << "  " << std::setw(3) << int(s.bus) << "  0x"
+                      << std::hex << std::setw(2) << std::setfill('0') << int(s.address) << std::dec << std::setfill(' ') << "  ";
+
+            for (int pin = 15; pin >= 0; pin--) {
+                uint16_t bit = uint16_t(1) << pin;
+                char c = (s.iodir & bit) ? ((s.gpio & bit) ? '1' : '0') : ((s.olat & bit) ? 'H' : 'L');
+                std::cout << ((s.intf & bit) ? '*' : c);
+                if (pin == 8) std::cout << ' ';
+            }
+
+            std::cout << "  0x" << std::hex << std::setw(4) << std::setfill('0') << s.intf << std::dec << std::setfill(' ')
+                      << std::setw(9) << s.updates << std::setw(9) << s.changes
+                      << std::setw(10) << (s.timestamp ? (now - s.timestamp) / 1000000 : 0) << "\n";
+        }
+
+        std::cout << "\n bus                          transactions   errors   bytes/s\n";
+        for (uint32_t b = 0; b < shm.buses(); b++) {
+            ShmBusStats st;
+            if (!shm.busStats(b, st)) continue;
+            uint64_t rate = (st.bytes - lastBytes[b]) * 1000 / uint64_t(intervalMs);
+            lastBytes[b] = st.bytes;
+            std::cout << " " << std::left << std::setw(28) << st.name << std::right
+                      << std::setw(13) << st.transactions << std::setw(9) << st.errors << std::setw(10) << rate << "\n";
+        }
+        std::cout << std::flush;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+    }
+    return 0;
+}